@@ -0,0 +1,132 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/arena.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+using namespace std;
+
+namespace parsco {
+
+using detail::g_current_arena;
+using detail::g_current_node_arena;
+
+namespace {
+
+size_t round_up( size_t n, size_t to ) {
+  return ( n + to - 1 ) / to * to;
+}
+
+} // namespace
+
+/****************************************************************
+** frame_arena
+*****************************************************************/
+frame_arena::frame_arena( size_t chunk_size )
+  : chunk_size_( chunk_size ) {}
+
+frame_arena::~frame_arena() noexcept {
+  // If this fires then some parser outlived the parse that it
+  // was created in.
+  assert( live_ == 0 );
+  while( chunks_ != nullptr ) {
+    chunk* next = chunks_->next;
+    ::operator delete( chunks_, chunks_->size );
+    chunks_ = next;
+  }
+}
+
+void frame_arena::new_chunk( size_t min_size ) {
+  size_t const header =
+      round_up( sizeof( chunk ), kGranularity );
+  size_t const size = max( chunk_size_, min_size + header );
+  char* mem = static_cast<char*>( ::operator new( size ) );
+  chunks_   = new( mem ) chunk{ chunks_, size };
+  cur_      = mem + header;
+  end_      = mem + size;
+  reserved_ += size;
+}
+
+void* frame_arena::allocate_slow( size_t size, size_t& count ) {
+  size_t const cls = ( size + kGranularity - 1 ) / kGranularity;
+  if( cls > kNumClasses ) return ::operator new( size );
+  ++live_;
+  ++count;
+  if( free_node* n = free_lists_[cls]; n != nullptr ) {
+    free_lists_[cls] = n->next;
+    return n;
+  }
+  size_t const rounded = cls * kGranularity;
+  if( size_t( end_ - cur_ ) < rounded ) new_chunk( rounded );
+  void* res = cur_;
+  cur_ += rounded;
+  return res;
+}
+
+void frame_arena::deallocate_slow( void* p,
+                                   size_t size ) noexcept {
+  // Only frames that are too large for the arena come here.
+  assert( size > kMaxFrame );
+  ::operator delete( p, size );
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+frame_arena* current_arena() noexcept { return g_current_arena; }
+
+arena_scope::arena_scope( frame_arena& arena ) noexcept
+  : prev_( g_current_arena ) {
+  g_current_arena = &arena;
+}
+
+arena_scope::~arena_scope() noexcept { g_current_arena = prev_; }
+
+ensure_arena::ensure_arena() {
+  if( g_current_arena != nullptr ) return;
+  own_.emplace();
+  scope_.emplace( *own_ );
+}
+
+frame_arena* current_node_arena() noexcept {
+  return g_current_node_arena;
+}
+
+node_arena_scope::node_arena_scope( frame_arena& arena ) noexcept
+  : prev_( g_current_node_arena ) {
+  g_current_node_arena = &arena;
+}
+
+node_arena_scope::~node_arena_scope() noexcept {
+  g_current_node_arena = prev_;
+}
+
+} // namespace parsco
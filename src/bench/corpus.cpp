@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "corpus.hpp"
+
+// C++ standard library
+#include <random>
+
+using namespace std;
+
+namespace bench {
+
+namespace {
+
+using rng = mt19937;
+
+int uniform( rng& r, int lo, int hi ) {
+  return uniform_int_distribution<int>( lo, hi )( r );
+}
+
+void append_word( rng& r, string& out ) {
+  int const len = uniform( r, 3, 12 );
+  out += '"';
+  for( int i = 0; i < len; ++i )
+    out += char( 'a' + uniform( r, 0, 25 ) );
+  out += '"';
+}
+
+void append_number( rng& r, string& out ) {
+  if( uniform( r, 0, 1 ) == 0 )
+    out += to_string( uniform( r, -100000, 100000 ) );
+  else
+    out += to_string( uniform( r, 0, 99999 ) ) + '.' +
+           to_string( uniform( r, 0, 999 ) );
+}
+
+void append_scalar( rng& r, string& out ) {
+  switch( uniform( r, 0, 2 ) ) {
+    case 0: append_number( r, out ); break;
+    case 1: append_word( r, out ); break;
+    case 2: out += uniform( r, 0, 1 ) ? "true" : "false"; break;
+  }
+}
+
+void append_list( rng& r, string& out ) {
+  out += "[ ";
+  int const n = uniform( r, 1, 6 );
+  for( int i = 0; i < n; ++i ) {
+    if( i > 0 ) out += ", ";
+    append_scalar( r, out );
+  }
+  out += " ]";
+}
+
+void append_document( rng& r, int id, string& out ) {
+  out += "{ \"id\": " + to_string( id ) + ", \"name\": ";
+  append_word( r, out );
+  out += ", \"score\": ";
+  append_number( r, out );
+  out += ", \"active\": ";
+  out += uniform( r, 0, 1 ) ? "true" : "false";
+  out += ", \"tags\": ";
+  append_list( r, out );
+  out += ", \"address\": { \"city\": ";
+  append_word( r, out );
+  out += ", \"zip\": " + to_string( uniform( r, 10000, 99999 ) );
+  out += " }, \"history\": [ ";
+  int const n = uniform( r, 1, 4 );
+  for( int i = 0; i < n; ++i ) {
+    if( i > 0 ) out += ", ";
+    append_list( r, out );
+  }
+  out += " ] }\n";
+}
+
+} // namespace
+
+string json_corpus( size_t bytes ) {
+  rng    r( 42 );
+  string out;
+  out.reserve( bytes + 512 );
+  for( int id = 0; out.size() < bytes; ++id )
+    append_document( r, id, out );
+  return out;
+}
+
+string ip_corpus( size_t bytes ) {
+  rng    r( 42 );
+  string out;
+  out.reserve( bytes + 32 );
+  while( out.size() < bytes ) {
+    for( int i = 0; i < 4; ++i ) {
+      if( i > 0 ) out += '.';
+      out += to_string( uniform( r, 0, 255 ) );
+    }
+    if( uniform( r, 0, 3 ) == 0 )
+      out += '/' + to_string( uniform( r, 0, 32 ) );
+    out += '\n';
+  }
+  return out;
+}
+
+} // namespace bench
@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <cstddef>
+#include <string>
+
+/****************************************************************
+** Corpus Generators
+*****************************************************************/
+// These generate the inputs for the grammar benchmarks. They are
+// deterministic (fixed seed) so that numbers are comparable
+// from one run to the next, and each one keeps appending until
+// the result is at least `bytes` long.
+namespace bench {
+
+// A sequence of JSON documents, one per line, in the format ac-
+// cepted by the grammar in example/json-grammar.hpp. Each docu-
+// ment is a table of a few hundred bytes with nested lists and
+// tables and a mix of all value types.
+std::string json_corpus( std::size_t bytes );
+
+// Newline-separated IPv4 addresses, some with a subnet mask, in
+// the format accepted by example/ip-address-grammar.hpp.
+std::string ip_corpus( std::size_t bytes );
+
+} // namespace bench
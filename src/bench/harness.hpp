@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "memory.hpp"
+
+// parsco
+#include "parsco/arena.hpp"
+#include "parsco/runner.hpp"
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/****************************************************************
+** Benchmark Harness
+*****************************************************************/
+namespace bench {
+
+// Runs the parser produced by `make` over `input` once per it-
+// eration and reports, in addition to the time:
+//
+//   bytes_per_second: throughput over the input.
+//   frames/byte:      coroutine frames allocated per input byte.
+//   recycled/frame:   fraction of those frames that reused the
+//                     memory of the one freed just before them.
+//   allocs/byte:      other heap allocations per input byte.
+//   peak_rss_MB:      peak resident set size of the process.
+//
+// All iterations share one frame arena, which is how a caller
+// that parses many inputs would normally run.
+template<typename MakeParser>
+void run( benchmark::State& state, std::string_view input,
+          MakeParser make ) {
+  parsco::frame_arena arena;
+  parsco::arena_scope scope( arena );
+  std::size_t const   heap_before     = heap_allocations();
+  std::size_t const   frames_before   = arena.frames();
+  std::size_t const   recycled_before = arena.recycled();
+  for( auto _ : state ) {
+    auto res = parsco::run_parser( "bench", input, make() );
+    if( !res.has_value() ) {
+      state.SkipWithError( res.get_error().what().c_str() );
+      break;
+    }
+    benchmark::DoNotOptimize( *res );
+  }
+  double const bytes =
+      double( state.iterations() ) * double( input.size() );
+  state.SetBytesProcessed( int64_t( bytes ) );
+  if( bytes == 0 ) return;
+  state.counters["frames/byte"] =
+      double( arena.frames() - frames_before ) / bytes;
+  if( arena.frames() > frames_before )
+    state.counters["recycled/frame"] =
+        double( arena.recycled() - recycled_before ) /
+        double( arena.frames() - frames_before );
+  state.counters["allocs/byte"] =
+      double( heap_allocations() - heap_before ) / bytes;
+  state.counters["peak_rss_MB"] = peak_rss_mb();
+}
+
+} // namespace bench
@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "corpus.hpp"
+#include "harness.hpp"
+#include "macro.hpp"
+
+// Grammars from the examples.
+#include "ip-address-grammar.hpp"
+#include "json-events-grammar.hpp"
+#include "json-fast-grammar.hpp"
+#include "json-grammar.hpp"
+
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/events.hpp"
+#include "parsco/parallel.hpp"
+#include "parsco/promise.hpp"
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace parsco;
+
+/****************************************************************
+** Grammar Macro-Benchmarks
+*****************************************************************/
+namespace bench {
+
+namespace {
+
+// Generating the larger corpora takes a while, so keep the last
+// one of each kind around; the benchmarks for a given grammar
+// are registered in order of size, so each one is generated
+// once.
+template<string ( *Generate )( size_t )>
+string const& corpus( size_t bytes ) {
+  static string cached;
+  if( cached.size() < bytes || cached.size() > bytes + 1024 )
+    cached = Generate( bytes );
+  return cached;
+}
+
+// These consume a whole corpus one item at a time, discarding
+// each one, so that memory usage does not grow with the input.
+parser<size_t> json_docs() {
+  size_t n = 0;
+  while( true ) {
+    auto d = co_await try_{ parse<json::Json, json::doc>() };
+    if( !d.has_value() ) break;
+    ++n;
+  }
+  co_return n;
+}
+
+parser<size_t> json_fast_docs() {
+  size_t n = 0;
+  while( true ) {
+    auto d = co_await try_{ json_fast::parse_doc() };
+    if( !d.has_value() ) break;
+    ++n;
+  }
+  co_return n;
+}
+
+parser<size_t> json_event_docs() {
+  size_t n = 0;
+  while( true ) {
+    auto d = co_await try_{
+        parse<json_events::Json, json_events::doc>() };
+    if( !d.has_value() ) break;
+    ++n;
+  }
+  co_return n;
+}
+
+parser<size_t> ip_addresses() {
+  size_t n = 0;
+  while( true ) {
+    auto ip = co_await try_{ parse_ip_address() };
+    if( !ip.has_value() ) break;
+    co_await blanks_sv();
+    ++n;
+  }
+  co_return n;
+}
+
+void BM_json( benchmark::State& state ) {
+  string const& input = corpus<json_corpus>( state.range( 0 ) );
+  run( state, input, [] { return exhaust( json_docs() ); } );
+}
+
+// Same corpus as BM_json, but parsed into the flat tape of the
+// json-fast example instead of a tree.
+void BM_json_fast( benchmark::State& state ) {
+  string const& input = corpus<json_corpus>( state.range( 0 ) );
+  run( state, input,
+       [] { return exhaust( json_fast_docs() ); } );
+}
+
+// Same corpus again, but only extracting the city of each docu-
+// ment via events, with the other subtrees skipped.
+void BM_json_events( benchmark::State& state ) {
+  struct counter : event_handler {
+    void scalar( string_view, string_view ) override { ++n; }
+    size_t n = 0;
+  };
+  string const& input = corpus<json_corpus>( state.range( 0 ) );
+  counter       handler;
+  event_sink    sink( handler,
+                   path_filter( { "address/city" } ) );
+  event_scope   scope( sink );
+  run( state, input,
+       [] { return exhaust( json_event_docs() ); } );
+  benchmark::DoNotOptimize( handler.n );
+}
+
+void BM_ip_address( benchmark::State& state ) {
+  string const& input = corpus<ip_corpus>( state.range( 0 ) );
+  run( state, input, [] { return exhaust( ip_addresses() ); } );
+}
+
+// Same corpus as BM_json, but with each line parsed separately
+// via parse_batch on a pool with one thread per hardware thread.
+void BM_json_batch( benchmark::State& state ) {
+  string const& input = corpus<json_corpus>( state.range( 0 ) );
+  vector<string_view> lines;
+  for( size_t start = 0; start < input.size(); ) {
+    size_t end = input.find( '\n', start );
+    if( end == string::npos ) end = input.size();
+    lines.push_back(
+        string_view( input ).substr( start, end - start ) );
+    start = end + 1;
+  }
+  thread_pool pool;
+  for( auto _ : state ) {
+    auto res = parse_batch<json::Json, json::doc>( "bench",
+                                                   lines, pool );
+    for( auto const& r : res ) {
+      if( r.has_value() ) continue;
+      state.SkipWithError( r.get_error().what().c_str() );
+      return;
+    }
+    benchmark::DoNotOptimize( res );
+  }
+  state.SetBytesProcessed( state.iterations() * input.size() );
+  state.counters["threads"] = pool.workers();
+  state.counters["peak_rss_MB"] = peak_rss_mb();
+}
+
+// Same corpus again, but parsed as a whole with parallel_many.
+void BM_json_parallel_many( benchmark::State& state ) {
+  string const& input = corpus<json_corpus>( state.range( 0 ) );
+  thread_pool   pool;
+  run( state, input, [&] {
+    return parallel_many( pool, delimited_by( '\n' ), [] {
+      return parse<json::Json, json::doc>();
+    } );
+  } );
+  state.counters["threads"] = pool.workers();
+}
+
+} // namespace
+
+void register_macro_benchmarks( size_t max_bytes ) {
+  auto add = [&]( char const* name, auto fn ) {
+    auto* b = benchmark::RegisterBenchmark( name, fn );
+    b->Unit( benchmark::kMillisecond );
+    for( size_t n = 1 << 10; n <= max_bytes; n *= 32 )
+      b->Arg( int64_t( n ) );
+    return b;
+  };
+  add( "BM_json", BM_json );
+  add( "BM_json_fast", BM_json_fast );
+  add( "BM_json_events", BM_json_events );
+  // The work happens on other threads, so CPU time of the main
+  // thread is meaningless here.
+  add( "BM_json_batch", BM_json_batch )->UseRealTime();
+  add( "BM_json_parallel_many", BM_json_parallel_many )
+      ->UseRealTime();
+  add( "BM_ip_address", BM_ip_address );
+}
+
+} // namespace bench
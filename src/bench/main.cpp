@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "macro.hpp"
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+constexpr string_view kMaxFlag = "--max_corpus_bytes=";
+
+// Parses e.g. "1024", "64K", "32M", "1G".
+size_t parse_size( string_view s ) {
+  char*  end = nullptr;
+  size_t n   = strtoull( s.data(), &end, 10 );
+  switch( *end ) {
+    case 'G': n <<= 10; [[fallthrough]];
+    case 'M': n <<= 10; [[fallthrough]];
+    case 'K': n <<= 10; break;
+  }
+  return n;
+}
+
+} // namespace
+
+/****************************************************************
+** main
+*****************************************************************/
+// In addition to the usual google benchmark flags, this takes
+// --max_corpus_bytes=N (default 1G), which caps the size of the
+// inputs used for the grammar benchmarks.
+int main( int argc, char** argv ) {
+  size_t max_bytes = size_t( 1 ) << 30;
+  int    out       = 1;
+  for( int i = 1; i < argc; ++i ) {
+    string_view const arg = argv[i];
+    if( arg.starts_with( kMaxFlag ) )
+      max_bytes = parse_size( arg.substr( kMaxFlag.size() ) );
+    else
+      argv[out++] = argv[i];
+  }
+  argc = out;
+
+  bench::register_macro_benchmarks( max_bytes );
+  benchmark::Initialize( &argc, argv );
+  if( benchmark::ReportUnrecognizedArguments( argc, argv ) )
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "memory.hpp"
+
+// C++ standard library
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// System
+#include <sys/resource.h>
+
+using namespace std;
+
+namespace {
+
+atomic<size_t> g_heap_allocations{ 0 };
+
+void* counted_alloc( size_t size ) {
+  g_heap_allocations.fetch_add( 1, memory_order_relaxed );
+  if( size == 0 ) size = 1;
+  void* p = malloc( size );
+  if( p == nullptr ) throw bad_alloc{};
+  return p;
+}
+
+void* counted_alloc( size_t size, align_val_t al ) {
+  g_heap_allocations.fetch_add( 1, memory_order_relaxed );
+  size_t const align = static_cast<size_t>( al );
+  // aligned_alloc requires the size to be a multiple of the
+  // alignment.
+  size = ( size + align - 1 ) / align * align;
+  if( size == 0 ) size = align;
+  void* p = aligned_alloc( align, size );
+  if( p == nullptr ) throw bad_alloc{};
+  return p;
+}
+
+} // namespace
+
+/****************************************************************
+** Global operator new/delete replacements
+*****************************************************************/
+void* operator new( size_t size ) {
+  return counted_alloc( size );
+}
+
+void* operator new[]( size_t size ) {
+  return counted_alloc( size );
+}
+
+void* operator new( size_t size, align_val_t al ) {
+  return counted_alloc( size, al );
+}
+
+void* operator new[]( size_t size, align_val_t al ) {
+  return counted_alloc( size, al );
+}
+
+void operator delete( void* p ) noexcept { free( p ); }
+void operator delete[]( void* p ) noexcept { free( p ); }
+void operator delete( void* p, size_t ) noexcept { free( p ); }
+void operator delete[]( void* p, size_t ) noexcept { free( p ); }
+
+void operator delete( void* p, align_val_t ) noexcept {
+  free( p );
+}
+
+void operator delete[]( void* p, align_val_t ) noexcept {
+  free( p );
+}
+
+void operator delete( void* p, size_t, align_val_t ) noexcept {
+  free( p );
+}
+
+void operator delete[]( void* p, size_t, align_val_t ) noexcept {
+  free( p );
+}
+
+/****************************************************************
+** Public API
+*****************************************************************/
+namespace bench {
+
+size_t heap_allocations() {
+  return g_heap_allocations.load( memory_order_relaxed );
+}
+
+double peak_rss_mb() {
+  rusage usage{};
+  getrusage( RUSAGE_SELF, &usage );
+  // ru_maxrss is in kilobytes on Linux.
+  return double( usage.ru_maxrss ) / 1024.0;
+}
+
+} // namespace bench
@@ -0,0 +1,204 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "harness.hpp"
+
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/promise.hpp"
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <string>
+
+using namespace std;
+using namespace parsco;
+
+/****************************************************************
+** Primitive Micro-Benchmarks
+*****************************************************************/
+// Each of these exercises one combinator in a loop over an input
+// of state.range( 0 ) bytes, so that the cost per element of the
+// combinator itself dominates.
+namespace bench {
+
+namespace {
+
+string repeat( string_view unit, size_t bytes ) {
+  string res;
+  res.reserve( bytes + unit.size() );
+  while( res.size() < bytes ) res += unit;
+  return res;
+}
+
+// A parser that is not a builtin, so that combinators over it
+// can't take any shortcuts.
+parser<char> parse_a() { co_return co_await chr( 'a' ); }
+
+/****************************************************************
+** chr
+*****************************************************************/
+parser<> chr_loop( size_t n ) {
+  for( size_t i = 0; i < n; ++i ) co_await chr( 'a' );
+}
+
+void BM_chr( benchmark::State& state ) {
+  string const input = repeat( "a", state.range( 0 ) );
+  run( state, input, [&] { return chr_loop( input.size() ); } );
+}
+
+/****************************************************************
+** many
+*****************************************************************/
+void BM_many( benchmark::State& state ) {
+  string const input = repeat( "a", state.range( 0 ) );
+  run( state, input, [] { return many( parse_a ); } );
+}
+
+/****************************************************************
+** many_fold
+*****************************************************************/
+// Same as BM_many, but without collecting the results.
+void BM_many_fold( benchmark::State& state ) {
+  string const input = repeat( "a", state.range( 0 ) );
+  run( state, input, [] {
+    return many_fold(
+        size_t{ 0 }, []( size_t n, char ) { return n + 1; },
+        parse_a );
+  } );
+}
+
+/****************************************************************
+** first
+*****************************************************************/
+void BM_first( benchmark::State& state ) {
+  string const input = repeat( "c", state.range( 0 ) );
+  run( state, input, [] {
+    return many( [] {
+      return first( chr( 'a' ), chr( 'b' ), chr( 'c' ) );
+    } );
+  } );
+}
+
+/****************************************************************
+** operators
+*****************************************************************/
+// An expression built from >>, << and | over builtins, which
+// should run in place without creating any frames of its own.
+void BM_operators( benchmark::State& state ) {
+  string const input = repeat( " ,x;y", state.range( 0 ) );
+  run( state, input, [] {
+    return many( [] {
+      return ( blanks_sv() >> chr( ',' ) << chr( 'x' ) ) |
+             ( chr( ';' ) << chr( 'y' ) );
+    } );
+  } );
+}
+
+/****************************************************************
+** keyword
+*****************************************************************/
+void BM_keyword( benchmark::State& state ) {
+  string const input = repeat( "false", state.range( 0 ) );
+  run( state, input, [] {
+    return many( [] {
+      return keyword<"true", "false", "null">();
+    } );
+  } );
+}
+
+/****************************************************************
+** interleave
+*****************************************************************/
+void BM_interleave( benchmark::State& state ) {
+  string const input = repeat( "a,", state.range( 0 ) ) + "a";
+  run( state, input, [] {
+    return interleave( [] { return chr( 'a' ); },
+                       [] { return chr( ',' ); } );
+  } );
+}
+
+/****************************************************************
+** seq
+*****************************************************************/
+void BM_seq( benchmark::State& state ) {
+  string const input = repeat( "ab", state.range( 0 ) );
+  run( state, input, [] {
+    return many( [] { return seq( chr( 'a' ), chr( 'b' ) ); } );
+  } );
+}
+
+/****************************************************************
+** invoke
+*****************************************************************/
+void BM_invoke( benchmark::State& state ) {
+  string const input = repeat( "ab", state.range( 0 ) );
+  run( state, input, [] {
+    return many( [] {
+      return parsco::invoke(
+          []( char l, char r ) { return l < r; },
+          chr( 'a' ), chr( 'b' ) );
+    } );
+  } );
+}
+
+/****************************************************************
+** try_
+*****************************************************************/
+// Every iteration fails once and backtracks, then succeeds.
+parser<> try_loop( size_t n ) {
+  for( size_t i = 0; i < n; ++i ) {
+    co_await try_{ chr( 'b' ) };
+    co_await chr( 'a' );
+  }
+}
+
+void BM_try( benchmark::State& state ) {
+  string const input = repeat( "a", state.range( 0 ) );
+  run( state, input, [&] { return try_loop( input.size() ); } );
+}
+
+} // namespace
+
+#define PARSCO_MICRO( name ) \
+  BENCHMARK( name )->RangeMultiplier( 32 )->Range( 1 << 10,    \
+                                                   1 << 20 )
+
+PARSCO_MICRO( BM_chr );
+PARSCO_MICRO( BM_many );
+PARSCO_MICRO( BM_many_fold );
+PARSCO_MICRO( BM_first );
+PARSCO_MICRO( BM_operators );
+PARSCO_MICRO( BM_keyword );
+PARSCO_MICRO( BM_interleave );
+PARSCO_MICRO( BM_seq );
+PARSCO_MICRO( BM_invoke );
+PARSCO_MICRO( BM_try );
+
+} // namespace bench
@@ -37,51 +37,36 @@ namespace parsco {
 
 namespace {
 
-bool is_digit( char c ) { return ( c >= '0' && c <= '9' ); }
+constexpr charset kDigit    = charset::range( '0', '9' );
+constexpr charset kLower    = charset::range( 'a', 'z' );
+constexpr charset kUpper    = charset::range( 'A', 'Z' );
+constexpr charset kAlpha    = kLower | kUpper;
+constexpr charset kAlphanum = kAlpha | kDigit;
+constexpr charset kBlank    = charset( " \n\r\t" );
+constexpr charset kCrlf     = charset( "\r\n" );
 
-bool is_lower( char c ) { return ( c >= 'a' && c <= 'z' ); }
+} // namespace
 
-bool is_upper( char c ) { return ( c >= 'A' && c <= 'Z' ); }
+builtin_next_char any_chr() { return builtin_next_char{}; }
 
-bool is_alpha( char c ) {
-  return is_lower( c ) || is_upper( c );
-}
+builtin_peek_char peek_char() { return builtin_peek_char{}; }
 
-bool is_blank( char c ) {
-  return ( c == ' ' ) || ( c == '\n' ) || ( c == '\r' ) ||
-         ( c == '\t' );
-}
+builtin_position position() { return builtin_position{}; }
 
-bool is_alphanum( char c ) {
-  return is_digit( c ) || ( c >= 'a' && c <= 'z' ) ||
-         ( c >= 'A' && c <= 'Z' );
-}
+builtin_chr chr( char c ) { return builtin_chr{ c }; }
 
-} // namespace
+char_class lower() { return one_of( kLower ); }
 
-parser<char> any_chr() {
-  co_return co_await builtin_next_char{};
-}
+char_class upper() { return one_of( kUpper ); }
 
-parser<char> chr( char c ) {
-  char parsed_c = co_await builtin_next_char{};
-  if( parsed_c != c )
-    co_await fail( string( "expected '" ) + c + "'" );
-  co_return c;
-}
-
-parser<char> lower() { return pred( is_lower ); }
-
-parser<char> upper() { return pred( is_upper ); }
+char_class alpha() { return one_of( kAlpha ); }
 
-parser<char> alpha() { return pred( is_alpha ); }
+char_class alphanum() { return one_of( kAlphanum ); }
 
-parser<char> alphanum() { return pred( is_alphanum ); }
-
-parser<char> space() { return chr( ' ' ); }
-parser<char> crlf() { return one_of( "\r\n" ); }
-parser<char> tab() { return chr( '\t' ); }
-parser<char> blank() { return pred( is_blank ); }
+builtin_chr space() { return chr( ' ' ); }
+char_class  crlf() { return one_of( kCrlf ); }
+builtin_chr tab() { return chr( '\t' ); }
+char_class  blank() { return one_of( kBlank ); }
 
 parser<string> blanks() {
   co_return string( co_await builtin_blanks{} );
@@ -91,35 +76,40 @@ parser<string> identifier() {
   co_return string( co_await builtin_identifier{} );
 }
 
-parser<char> digit() { return pred( is_digit ); }
+char_class digit() { return one_of( kDigit ); }
+
+parser<> str( string s ) { co_await builtin_str{ s }; }
+
+builtin_str str( string_view s ) { return builtin_str{ s }; }
+
+builtin_str str( char const* s ) { return builtin_str{ s }; }
+
+builtin_one_of one_of( string sv ) {
+  return one_of( charset( sv ) );
+}
+
+builtin_one_of not_of( string sv ) {
+  return not_of( charset( sv ) );
+}
 
-parser<> str( string sv ) {
-  for( char c : sv ) co_await chr( c );
+builtin_one_of one_of( charset set ) {
+  return builtin_one_of{ set };
 }
 
-parser<char> one_of( string sv ) {
-  return pred( [sv]( char c ) {
-    return sv.find_first_of( c ) != string::npos;
-  } );
+builtin_one_of not_of( charset set ) {
+  return builtin_one_of{ ~set };
 }
 
-parser<char> not_of( string sv ) {
-  return pred( [sv]( char c ) {
-    return sv.find_first_of( c ) == string::npos;
-  } );
+builtin_span span_of( charset set ) {
+  return builtin_span{ set };
 }
 
-parser<> eof() {
-  result_t<char> c = co_await try_{ any_chr() };
-  if( c.has_value() )
-    // If we're here that means that there is more input in the
-    // buffer, and thus that the `eof` parser (which requires
-    // eof) has failed, meaning that the previous parsers did not
-    // consume all of the input.
-    co_await fail(
-        "failed to parse all characters in input stream" );
+builtin_span_not span_not_of( charset set ) {
+  return builtin_span_not{ set };
 }
 
+builtin_eof eof() { return builtin_eof{}; }
+
 parser<string_view> double_quoted_str() {
   co_return co_await builtin_double_quoted{};
 }
@@ -129,8 +119,15 @@ parser<string_view> single_quoted_str() {
 }
 
 parser<string> quoted_str() {
-  co_return string( co_await first( double_quoted_str(),
-                                    single_quoted_str() ) );
+  co_return string( co_await builtin_quoted{} );
 }
 
+builtin_blanks blanks_sv() { return builtin_blanks{}; }
+
+builtin_identifier identifier_sv() {
+  return builtin_identifier{};
+}
+
+builtin_quoted quoted_sv() { return builtin_quoted{}; }
+
 } // namespace parsco
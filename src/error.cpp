@@ -28,22 +28,108 @@
 #include "parsco/error.hpp"
 
 // C++ standard library
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <string>
 
 using namespace std;
 
 namespace parsco {
 
+/****************************************************************
+** error
+*****************************************************************/
+error::error( string msg )
+  : code_( error_code::message ),
+    owned_( make_shared<string const>( std::move( msg ) ) ) {
+  text_ = owned_->c_str();
+  detail::count_error();
+}
+
+string error::what() const {
+  switch( code_ ) {
+    case error_code::none: return "";
+    case error_code::message: return text_;
+    case error_code::expected:
+      return string( "expected " ) + text_;
+    case error_code::expected_char:
+      return string( "expected '" ) + c_ + "'";
+    case error_code::eof: return "EOF";
+  }
+  return "";
+}
+
+/****************************************************************
+** ErrorPos
+*****************************************************************/
+namespace {
+
+// Calls f with the offset of each newline in [start, end), in
+// order.
+template<typename Func>
+void for_each_newline( string_view in, int start, int end,
+                       Func f ) {
+  char const* const base = in.data();
+  char const*       p    = base + start;
+  char const* const last = base + end;
+  while( p < last ) {
+    auto* nl =
+        static_cast<char const*>( memchr( p, '\n', last - p ) );
+    if( nl == nullptr ) break;
+    f( int( nl - base ) );
+    p = nl + 1;
+  }
+}
+
+} // namespace
+
 ErrorPos ErrorPos::from_index( string_view in, int idx ) {
   assert( idx <= int( in.size() ) );
   ErrorPos res{ 1, 1 };
-  for( int i = 0; i < idx; ++i ) {
-    ++res.col;
-    if( in[i] == '\n' ) {
-      ++res.line;
-      res.col = 1;
-    }
-  }
+  int      line_start = 0;
+  for_each_newline( in, 0, idx, [&]( int nl ) {
+    ++res.line;
+    line_start = nl + 1;
+  } );
+  res.col = max( idx - line_start, 0 ) + 1;
+  return res;
+}
+
+/****************************************************************
+** line_index
+*****************************************************************/
+void line_index::scan_to( int idx ) {
+  if( idx <= scanned_ ) return;
+  for_each_newline( in_, scanned_, idx, [&]( int nl ) {
+    newlines_.push_back( nl );
+  } );
+  scanned_ = idx;
+}
+
+ErrorPos line_index::pos_of( int idx ) {
+  assert( idx <= int( in_.size() ) );
+  scan_to( idx );
+  // Number of newlines before idx.
+  int const before = int(
+      lower_bound( newlines_.begin(), newlines_.end(), idx ) -
+      newlines_.begin() );
+  int const line_start =
+      ( before == 0 ) ? 0 : newlines_[before - 1] + 1;
+  return ErrorPos{ .line = before + 1,
+                   .col  = max( idx - line_start, 0 ) + 1 };
+}
+
+string format_error( string_view filename, ErrorPos pos,
+                     error const& e ) {
+  string res( filename );
+  res += ":error:";
+  res += to_string( pos.line );
+  res += ':';
+  res += to_string( pos.col );
+  res += ' ';
+  res += e.what();
   return res;
 }
 
@@ -0,0 +1,205 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/events.hpp"
+
+// parsco
+#include "parsco/unreachable.hpp"
+
+// C++ standard library
+#include <algorithm>
+
+using namespace std;
+
+namespace parsco {
+
+namespace {
+
+thread_local event_sink* g_current_event_sink = nullptr;
+
+vector<string> split_path( string_view pattern ) {
+  vector<string> res;
+  if( pattern.empty() ) return res;
+  while( true ) {
+    size_t const slash = pattern.find( '/' );
+    res.emplace_back( pattern.substr( 0, slash ) );
+    if( slash == string_view::npos ) break;
+    pattern.remove_prefix( slash + 1 );
+  }
+  return res;
+}
+
+} // namespace
+
+/****************************************************************
+** path_filter
+*****************************************************************/
+path_filter::path_filter( vector<string_view> const& patterns )
+  : everything_( false ) {
+  for( string_view p : patterns )
+    patterns_.push_back( split_path( p ) );
+}
+
+path_filter::match path_filter::check(
+    span<string_view const> path ) const {
+  if( everything_ ) return match::inside;
+  match res = match::none;
+  for( vector<string> const& pattern : patterns_ ) {
+    size_t const n = min( pattern.size(), path.size() );
+    bool const   matches =
+        equal( pattern.begin(), pattern.begin() + n,
+               path.begin(),
+               []( string const& l, string_view r ) {
+                 return l == "*" || l == r;
+               } );
+    if( !matches ) continue;
+    if( path.size() >= pattern.size() ) return match::inside;
+    res = match::ancestor;
+  }
+  return res;
+}
+
+/****************************************************************
+** event_recorder
+*****************************************************************/
+void event_recorder::begin( string_view name ) {
+  events_.push_back( { .k = kind::begin, .name = name } );
+}
+
+void event_recorder::end( string_view name ) {
+  events_.push_back( { .k = kind::end, .name = name } );
+}
+
+void event_recorder::scalar( string_view name,
+                             string_view text ) {
+  events_.push_back(
+      { .k = kind::scalar, .name = name, .text = text } );
+}
+
+void event_recorder::replay( event_handler& to ) const {
+  for( event const& e : events_ ) {
+    switch( e.k ) {
+      case kind::begin: to.begin( e.name ); break;
+      case kind::end: to.end( e.name ); break;
+      case kind::scalar: to.scalar( e.name, e.text ); break;
+    }
+  }
+}
+
+/****************************************************************
+** event_sink
+*****************************************************************/
+event_sink::event_sink( event_handler& handler,
+                        path_filter    filter )
+  : handler_( &handler ), filter_( std::move( filter ) ) {}
+
+event_sink::event_sink( event_sink const& outer,
+                        event_handler&    handler )
+  : handler_( &handler ),
+    filter_( outer.filter_ ),
+    path_( outer.path_ ),
+    muted_( outer.muted_ ),
+    wanted_( outer.wanted_ ) {}
+
+void event_sink::merge( event_sink const&     part,
+                        event_recorder const& events ) {
+  events.replay( *handler_ );
+  skipped_ += part.skipped_;
+}
+
+event_sink::subtree event_sink::enter( string_view name ) {
+  if( muted_ > 0 ) {
+    ++muted_;
+    return subtree::skipped;
+  }
+  if( wanted_ > 0 ) {
+    ++wanted_;
+    handler_->begin( name );
+    return subtree::wanted;
+  }
+  path_.push_back( name );
+  switch( filter_.check( path_ ) ) {
+    case path_filter::match::none:
+      path_.pop_back();
+      ++muted_;
+      ++skipped_;
+      return subtree::skipped;
+    case path_filter::match::ancestor:
+      handler_->begin( name );
+      return subtree::ancestor;
+    case path_filter::match::inside:
+      ++wanted_;
+      handler_->begin( name );
+      return subtree::wanted;
+  }
+  parsco::unreachable();
+}
+
+void event_sink::leave( subtree s, string_view name,
+                        bool finished ) {
+  switch( s ) {
+    case subtree::skipped:
+      --muted_;
+      return;
+    case subtree::ancestor:
+      path_.pop_back();
+      break;
+    case subtree::wanted:
+      if( --wanted_ == 0 ) path_.pop_back();
+      break;
+  }
+  if( finished ) handler_->end( name );
+}
+
+bool event_sink::wants_scalar( string_view name ) {
+  if( muted_ > 0 ) return false;
+  if( wanted_ > 0 ) return true;
+  path_.push_back( name );
+  bool const res =
+      ( filter_.check( path_ ) == path_filter::match::inside );
+  path_.pop_back();
+  if( !res ) ++skipped_;
+  return res;
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+event_sink* current_event_sink() noexcept {
+  return g_current_event_sink;
+}
+
+event_scope::event_scope( event_sink& sink ) noexcept
+  : prev_( g_current_event_sink ) {
+  g_current_event_sink = &sink;
+}
+
+event_scope::~event_scope() noexcept {
+  g_current_event_sink = prev_;
+}
+
+} // namespace parsco
@@ -90,8 +90,10 @@ parser<string> parse_hello_world() {
 
   // Our grammar rules say that the two words must have the same
   // capitalization.
-  ( h == 'h' ) ? co_await str( "world" )
-               : co_await str( "World" );
+  if( h == 'h' )
+    co_await str( "world" );
+  else
+    co_await str( "World" );
 
   // Parse zero or more exclamation marks.
   string excls = co_await many( chr, '!' );
@@ -25,68 +25,19 @@
  * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
  * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include "ip-address-grammar.hpp"
 
 // parsco
-#include "parsco/combinator.hpp"
-#include "parsco/ext-basic.hpp"
-#include "parsco/ext-std.hpp"
-#include "parsco/promise.hpp"
 #include "parsco/runner.hpp"
 
 // C++ standard library
 #include <iostream>
-#include <optional>
+#include <string>
+#include <vector>
 
 using namespace std;
 using namespace parsco;
 
-struct ipv4_address {
-  int           n1;
-  int           n2;
-  int           n3;
-  int           n4;
-  optional<int> subnet_mask;
-};
-
-// Parsers for IPv4 address with optional subnet_mask, e.g.:
-//
-//   123.234.345.456
-//   123.234.345.0/16
-//
-// The bit subnet_mask on the end, if present, must be <= 32.
-
-parser<int> parse_ip_number() {
-  int n = co_await parse_int();
-  if( n > 255 ) co_await fail( "ip values must be <= 255" );
-  co_return n;
-}
-
-parser<ipv4_address> parse_ip_address() {
-  ipv4_address result;
-
-  result.n1 = co_await parse_ip_number();
-  co_await chr( '.' );
-  result.n2 = co_await parse_ip_number();
-  co_await chr( '.' );
-  result.n3 = co_await parse_ip_number();
-  co_await chr( '.' );
-  result.n4 = co_await parse_ip_number();
-
-  // The try_ combinator returns the result wrapped in a
-  // `result_t` in order to signal (in a type-safe way) that the
-  // parser may or may not succeed and that it will backtrack if
-  // not successful.
-  result_t<char> slash = co_await try_{ chr( '/' ) };
-
-  if( slash.has_value() ) {
-    int mask = co_await parse_int();
-    if( mask > 32 ) co_await fail( "subnet mask must be <= 32" );
-    result.subnet_mask = mask;
-  }
-
-  co_return result;
-}
-
 /****************************************************************
 ** main
 *****************************************************************/
@@ -0,0 +1,179 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/charset.hpp"
+#include "parsco/combinator.hpp"
+#include "parsco/events.hpp"
+#include "parsco/ext.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <string_view>
+
+// This file contains a grammar for the same JSON as json-gram-
+// mar.hpp, but that emits events (see events.hpp) instead of
+// building anything, so that it can be run with parse_events.
+// Each table or list is a subtree named after the key that it is
+// the value of, and likewise for the scalars. The elements of a
+// list have empty names, so e.g. the path "tags/*" selects all
+// of the elements of the "tags" list.
+namespace json_events {
+
+// Type tag representing the language we are parsing.
+struct Json {};
+
+// The rules of this grammar yield nothing, so the parser_for for
+// a document returns just this tag.
+struct doc {};
+
+parsco::parser<> parse_value( std::string_view name );
+
+/****************************************************************
+** skip_nested
+*****************************************************************/
+// Steps over a table or list that is not wanted. It only keeps
+// track of the brackets and strings (which may contain brackets)
+// and jumps between them with span_not_of, without looking at
+// what is in between, so the subtree is not validated.
+inline parsco::parser<> skip_nested() {
+  using namespace parsco;
+  static constexpr charset kSpecial( "[]{}\"'" );
+  int depth = 0;
+  do {
+    co_await span_not_of( kSpecial );
+    char const c = co_await peek_char();
+    if( c == '"' || c == '\'' ) {
+      co_await quoted_sv();
+      continue;
+    }
+    co_await any_chr();
+    depth += ( c == '[' || c == '{' ) ? 1 : -1;
+  } while( depth > 0 );
+}
+
+/****************************************************************
+** table
+*****************************************************************/
+inline parsco::parser<> parse_table() {
+  using namespace parsco;
+  co_await chr( '{' );
+  co_await blanks_sv();
+  char const c = co_await peek_char();
+  if( c != '}' ) {
+    while( true ) {
+      co_await blanks_sv();
+      std::string_view const k = co_await quoted_sv();
+      co_await blanks_sv();
+      co_await chr( ':' );
+      co_await blanks_sv();
+      co_await parse_value( k );
+      co_await blanks_sv();
+      auto const comma = co_await try_{ chr( ',' ) };
+      if( !comma.has_value() ) break;
+    }
+  }
+  co_await chr( '}' );
+}
+
+/****************************************************************
+** list
+*****************************************************************/
+inline parsco::parser<> parse_list() {
+  using namespace parsco;
+  co_await chr( '[' );
+  co_await blanks_sv();
+  char const c = co_await peek_char();
+  if( c != ']' ) {
+    while( true ) {
+      co_await blanks_sv();
+      co_await parse_value( "" );
+      co_await blanks_sv();
+      auto const comma = co_await try_{ chr( ',' ) };
+      if( !comma.has_value() ) break;
+    }
+  }
+  co_await chr( ']' );
+}
+
+/****************************************************************
+** value
+*****************************************************************/
+inline parsco::parser<> parse_number() {
+  using namespace parsco;
+  // As in json-model.hpp, a double is tried before an int.
+  auto const d =
+      co_await try_{ skip( builtin_float<double>{} ) };
+  if( !d.has_value() ) co_await skip( builtin_int<int>{} );
+}
+
+inline parsco::parser<> parse_value( std::string_view name ) {
+  using namespace parsco;
+  char const c = co_await peek_char();
+  switch( c ) {
+    case '{': {
+      co_await emit( name, parse_table(), skip_nested );
+      break;
+    }
+    case '[': {
+      co_await emit( name, parse_list(), skip_nested );
+      break;
+    }
+    case '"':
+    case '\'': {
+      co_await emit_scalar( name, quoted_sv() );
+      break;
+    }
+    case 't':
+    case 'f': {
+      co_await emit_scalar( name, keyword<"true", "false">() );
+      break;
+    }
+    default: {
+      co_await emit_scalar( name, parse_number() );
+      break;
+    }
+  }
+}
+
+/****************************************************************
+** doc
+*****************************************************************/
+// The top-level table is not a subtree of its own, so the paths
+// start from its keys.
+inline parsco::parser<doc> parser_for( parsco::lang<Json>,
+                                       parsco::tag<doc> ) {
+  using namespace parsco;
+  co_await blanks_sv();
+  co_await parse_table();
+  co_await blanks_sv();
+  co_return doc{};
+}
+
+} // namespace json_events
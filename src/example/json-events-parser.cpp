@@ -0,0 +1,104 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "json-events-grammar.hpp"
+
+// parsco
+#include "parsco/runner.hpp"
+
+// C++ standard library
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace parsco;
+
+namespace {
+
+// Prints the events that it receives, indented by depth.
+struct printer : event_handler {
+  void begin( string_view name ) override {
+    cout << string( depth * 2, ' ' ) << "begin " << name << "\n";
+    ++depth;
+  }
+
+  void end( string_view name ) override {
+    --depth;
+    cout << string( depth * 2, ' ' ) << "end " << name << "\n";
+  }
+
+  void scalar( string_view name, string_view text ) override {
+    cout << string( depth * 2, ' ' ) << name << ": " << text
+         << "\n";
+  }
+
+  int depth = 0;
+};
+
+} // namespace
+
+/****************************************************************
+** main
+*****************************************************************/
+int main( int, char** ) {
+  constexpr string_view json = R"(
+    {
+      "here": [
+        "is",
+        5,
+        [ "some" ],
+        42
+      ],
+      "json": true,
+      "nested": { "hello": "world", "skip": [ 1, 2 ] }
+    }
+  )";
+
+  printer all;
+  cout << "all events:\n";
+  auto res = parse_events<json_events::Json, json_events::doc>(
+      "fake-file.json", json, all );
+  if( !res.has_value() ) {
+    cerr << "failed to parse json: " << res.get_error().what()
+         << "\n";
+    return 1;
+  }
+
+  // Only the elements of "here" and the "hello" member, with the
+  // other subtrees skipped over.
+  printer some;
+  cout << "filtered events:\n";
+  res = parse_events<json_events::Json, json_events::doc>(
+      "fake-file.json", json, some,
+      path_filter( { "here/*", "nested/hello" } ) );
+  if( !res.has_value() ) {
+    cerr << "failed to parse json: " << res.get_error().what()
+         << "\n";
+    return 1;
+  }
+  return 0;
+}
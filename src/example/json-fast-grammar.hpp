@@ -0,0 +1,158 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "json-fast-model.hpp"
+
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// This file contains a grammar for the same JSON as json-gram-
+// mar.hpp, but that builds the tape in json-fast-model.hpp in-
+// stead of a tree. Rather than returning the values that they
+// parse, the parsers append them to the tape that they are
+// given. If a parser fails then whatever it has appended is
+// left on the tape, which is fine here because nothing in this
+// grammar backtracks over a value.
+namespace json_fast {
+
+parsco::parser<> parse_value( tape* t );
+
+/****************************************************************
+** table
+*****************************************************************/
+inline parsco::parser<> parse_table( tape* t ) {
+  using namespace parsco;
+  std::uint32_t const start = t->open( kind::table );
+  co_await chr( '{' );
+  co_await blanks_sv();
+  char const c = co_await peek_char();
+  if( c != '}' ) {
+    while( true ) {
+      co_await blanks_sv();
+      std::string_view const k = co_await quoted_sv();
+      t->push_string( kind::key, k );
+      co_await blanks_sv();
+      co_await chr( ':' );
+      co_await blanks_sv();
+      co_await parse_value( t );
+      co_await blanks_sv();
+      auto const comma = co_await try_{ chr( ',' ) };
+      if( !comma.has_value() ) break;
+    }
+  }
+  co_await chr( '}' );
+  t->close( start );
+}
+
+/****************************************************************
+** list
+*****************************************************************/
+inline parsco::parser<> parse_list( tape* t ) {
+  using namespace parsco;
+  std::uint32_t const start = t->open( kind::list );
+  co_await chr( '[' );
+  co_await blanks_sv();
+  char const c = co_await peek_char();
+  if( c != ']' ) {
+    while( true ) {
+      co_await blanks_sv();
+      co_await parse_value( t );
+      co_await blanks_sv();
+      auto const comma = co_await try_{ chr( ',' ) };
+      if( !comma.has_value() ) break;
+    }
+  }
+  co_await chr( ']' );
+  t->close( start );
+}
+
+/****************************************************************
+** value
+*****************************************************************/
+// The kind of value is decided by its first char, so that no al-
+// ternative ever has to be backtracked out of, except for num-
+// bers: as in json-model.hpp, a double is tried before an int.
+inline parsco::parser<> parse_value( tape* t ) {
+  using namespace parsco;
+  char const c = co_await peek_char();
+  switch( c ) {
+    case '{': {
+      co_await parse_table( t );
+      break;
+    }
+    case '[': {
+      co_await parse_list( t );
+      break;
+    }
+    case '"':
+    case '\'': {
+      std::string_view const s = co_await quoted_sv();
+      t->push_string( kind::string, s );
+      break;
+    }
+    case 't':
+    case 'f': {
+      std::string_view const k =
+          co_await keyword<"true", "false">();
+      t->push_bool( k == "true" );
+      break;
+    }
+    default: {
+      auto const d = co_await try_{ builtin_float<double>{} };
+      if( d.has_value() ) {
+        t->push_double( *d );
+        break;
+      }
+      int const i = co_await builtin_int<int>{};
+      t->push_int( i );
+      break;
+    }
+  }
+}
+
+/****************************************************************
+** doc
+*****************************************************************/
+// A document is a table, possibly surrounded by blanks.
+inline parsco::parser<tape> parse_doc() {
+  using namespace parsco;
+  tape t;
+  co_await blanks_sv();
+  co_await parse_table( &t );
+  co_await blanks_sv();
+  co_return std::move( t );
+}
+
+} // namespace json_fast
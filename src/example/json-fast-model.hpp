@@ -0,0 +1,211 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// This file contains a compact alternative to the JSON model in
+// json-model.hpp. Instead of a tree of separately allocated
+// nodes, a document is stored as a flat array (a "tape") of
+// small fixed-size nodes in the order in which they appear in
+// the input, similar to what simdjson does. Strings are views
+// into the input, so the tape is the only memory that a parse
+// allocates, and the input must outlive it.
+namespace json_fast {
+
+enum class kind : std::uint8_t {
+  table,
+  list,
+  key,
+  string,
+  integer,
+  floating,
+  boolean
+};
+
+// A table or list is followed by its contents; for a table that
+// is each key followed by its value.
+struct node {
+  kind k = kind::table;
+  // For a table or list, the index of the first node after its
+  // contents, so that it can be skipped in one step. For a key
+  // or a string, its size.
+  std::uint32_t n = 0;
+  union {
+    char const* str = nullptr;
+    int         i;
+    double      d;
+    bool        b;
+  };
+};
+
+static_assert( sizeof( node ) == 16 );
+
+struct tape;
+
+// A handle to one value on a tape. It is only valid for as long
+// as the tape is alive and unchanged.
+struct value {
+  kind type() const { return get().k; }
+
+  std::string_view as_string() const;
+  int              as_int() const;
+  double           as_double() const;
+  bool             as_bool() const;
+
+  // For a table, the number of members; for a list, the number
+  // of elements.
+  int size() const;
+
+  // For a list, the element at index i. This walks the list, but
+  // each element is skipped in one step.
+  value operator[]( int i ) const;
+
+  // For a table, the value of the member with the given key.
+  std::optional<value> find( std::string_view key ) const;
+
+  tape const*   t   = nullptr;
+  std::uint32_t idx = 0;
+
+private:
+  node const& get() const;
+  // The index of the node after this value.
+  std::uint32_t end() const;
+};
+
+struct tape {
+  std::vector<node> nodes;
+
+  // The document, which is a table.
+  value root() const {
+    assert( !nodes.empty() );
+    return value{ this, 0 };
+  }
+
+  // The following are used by the parser to build the tape.
+  void push_string( kind k, std::string_view s ) {
+    node& nd = nodes.emplace_back();
+    nd.k     = k;
+    nd.n     = std::uint32_t( s.size() );
+    nd.str   = s.data();
+  }
+
+  void push_int( int i ) {
+    node& nd = nodes.emplace_back();
+    nd.k     = kind::integer;
+    nd.i     = i;
+  }
+
+  void push_double( double d ) {
+    node& nd = nodes.emplace_back();
+    nd.k     = kind::floating;
+    nd.d     = d;
+  }
+
+  void push_bool( bool b ) {
+    node& nd = nodes.emplace_back();
+    nd.k     = kind::boolean;
+    nd.b     = b;
+  }
+
+  // Starts a table or list and returns its index, which is to be
+  // passed to close once its contents have been pushed.
+  std::uint32_t open( kind k ) {
+    nodes.emplace_back().k = k;
+    return std::uint32_t( nodes.size() - 1 );
+  }
+
+  void close( std::uint32_t idx ) {
+    nodes[idx].n = std::uint32_t( nodes.size() );
+  }
+};
+
+/****************************************************************
+** value
+*****************************************************************/
+inline node const& value::get() const { return t->nodes[idx]; }
+
+inline std::uint32_t value::end() const {
+  node const& nd = get();
+  if( nd.k == kind::table || nd.k == kind::list ) return nd.n;
+  return idx + 1;
+}
+
+inline std::string_view value::as_string() const {
+  assert( type() == kind::string );
+  return std::string_view( get().str, get().n );
+}
+
+inline int value::as_int() const {
+  assert( type() == kind::integer );
+  return get().i;
+}
+
+inline double value::as_double() const {
+  assert( type() == kind::floating );
+  return get().d;
+}
+
+inline bool value::as_bool() const {
+  assert( type() == kind::boolean );
+  return get().b;
+}
+
+inline int value::size() const {
+  int n = 0;
+  for( value v{ t, idx + 1 }; v.idx < get().n; v.idx = v.end() )
+    ++n;
+  return ( type() == kind::table ) ? n / 2 : n;
+}
+
+inline value value::operator[]( int i ) const {
+  assert( type() == kind::list );
+  value v{ t, idx + 1 };
+  for( ; i > 0; --i ) v.idx = v.end();
+  assert( v.idx < get().n );
+  return v;
+}
+
+inline std::optional<value> value::find(
+    std::string_view key ) const {
+  assert( type() == kind::table );
+  for( std::uint32_t k = idx + 1; k < get().n; ) {
+    value const v{ t, k + 1 };
+    node const& nd = t->nodes[k];
+    if( std::string_view( nd.str, nd.n ) == key ) return v;
+    k = v.end();
+  }
+  return std::nullopt;
+}
+
+} // namespace json_fast
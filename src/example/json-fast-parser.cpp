@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "json-fast-grammar.hpp"
+
+// parsco
+#include "parsco/runner.hpp"
+
+// C++ standard library
+#include <cassert>
+#include <iostream>
+
+using namespace std;
+using namespace parsco;
+using namespace json_fast;
+
+/****************************************************************
+** main
+*****************************************************************/
+int main( int, char** ) {
+  constexpr string_view json = R"(
+    {
+      "here": [
+        "is",
+        5,
+        "some",
+        42
+      ],
+      "json": true,
+      "hello": "world"
+    }
+  )";
+
+  // The tape holds views into `json`, which must outlive it.
+  result_t<tape> doc =
+      run_parser( "fake-file.json", json, parse_doc() );
+
+  if( !doc.has_value() ) {
+    cerr << "failed to parse json: " << doc.get_error().what()
+         << "\n";
+    return 1;
+  }
+
+  cout << "succeeded to parse json into " << doc->nodes.size()
+       << " nodes.\n";
+
+  int answer = ( *doc->root().find( "here" ) )[3].as_int();
+  assert( answer == 42 );
+
+  cout << "doc.here[3] == " << answer << "\n";
+
+  // Deeply nested input, run on the trampoline so that it does
+  // not overflow the stack. Both the parse that succeeds and the
+  // one that fails (at the innermost list) have to unwind from
+  // that deep.
+  auto nested = []( int depth, string_view inner ) {
+    return "{\"a\": " + string( depth, '[' ) + string( inner ) +
+           string( depth, ']' ) + "}";
+  };
+  string const   deep = nested( 100000, "1" );
+  result_t<tape> ok =
+      run_parser_trampolined( "deep.json", deep, parse_doc() );
+  assert( ok.has_value() );
+  cout << "parsed " << ok->nodes.size()
+       << " nodes nested 100000 deep.\n";
+  string const   bad = nested( 100000, "x" );
+  result_t<tape> failed =
+      run_parser_trampolined( "bad.json", bad, parse_doc() );
+  assert( !failed.has_value() );
+  cout << failed.get_error().what() << "\n";
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "json-model.hpp"
+
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/ext-basic.hpp"
+#include "parsco/ext-std.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// This file contains the grammar for the JSON model in json-mod-
+// el.hpp. It is used by the json-parser example as well as by
+// the benchmarks.
+//
+// For ADL reasons, the parse_for extension point overrides for
+// the JSON model types must live in the same json namespace.
+namespace json {
+
+/****************************************************************
+** helpers
+*****************************************************************/
+template<typename T>
+parsco::parser<std::vector<T>> parse_vec() {
+  using namespace parsco;
+  return interleave(
+      [] { return blanks_sv() >> parse<Json, T>(); },
+      [] { return blanks_sv() >> chr( ',' ); } );
+}
+
+template<typename T>
+parsco::parser<std::vector<T>> bracketed_vec( char l, char r ) {
+  using namespace parsco;
+  return bracketed( blanks_sv() >> chr( l ), parse_vec<T>(),
+                    blanks_sv() >> chr( r ) );
+}
+
+/****************************************************************
+** string_val
+*****************************************************************/
+inline parsco::parser<string_val> parser_for(
+    parsco::lang<Json>, parsco::tag<string_val> ) {
+  using namespace parsco;
+  return emplace<string_val>( quoted_str() );
+}
+
+// Declaring the FIRST sets of the alternatives of value lets the
+// variant parser go straight to the right one (see ext.hpp).
+inline parsco::charset first_chars( parsco::lang<Json>,
+                                    parsco::tag<string_val> ) {
+  return parsco::charset( "\"'" );
+}
+
+/****************************************************************
+** boolean
+*****************************************************************/
+inline parsco::parser<boolean> parser_for(
+    parsco::lang<Json>, parsco::tag<boolean> ) {
+  using namespace parsco;
+  auto to_bool = []( std::string_view k ) {
+    return boolean{ k == "true" };
+  };
+  return invoke( to_bool, keyword<"true", "false">() );
+}
+
+inline parsco::charset first_chars( parsco::lang<Json>,
+                                    parsco::tag<boolean> ) {
+  return parsco::charset( "tf" );
+}
+
+/****************************************************************
+** number
+*****************************************************************/
+inline parsco::parser<number> parser_for( parsco::lang<Json>,
+                                          parsco::tag<number> ) {
+  // Delegate to variant parser, that's basically what number is.
+  co_return co_await parsco::parse<Json,
+                                   std::variant<double, int>>();
+}
+
+inline parsco::charset first_chars( parsco::lang<Json>,
+                                    parsco::tag<number> ) {
+  return parsco::charset::range( '0', '9' ) |
+         parsco::charset( "-." );
+}
+
+/****************************************************************
+** key_val
+*****************************************************************/
+inline parsco::parser<key_val> parser_for(
+    parsco::lang<Json>, parsco::tag<key_val> ) {
+  using namespace parsco;
+  return emplace<key_val>(
+      blanks_sv() >> quoted_str(),
+      blanks_sv() >> chr( ':' ) >> blanks_sv() >>
+          parse<Json, value>() );
+}
+
+/****************************************************************
+** table
+*****************************************************************/
+inline parsco::parser<table> parser_for( parsco::lang<Json>,
+                                         parsco::tag<table> ) {
+  co_return co_await bracketed_vec<key_val>( '{', '}' );
+}
+
+// These two skip leading blanks.
+inline parsco::charset first_chars( parsco::lang<Json>,
+                                    parsco::tag<table> ) {
+  return parsco::charset( "{ \n\r\t" );
+}
+
+/****************************************************************
+** list
+*****************************************************************/
+inline parsco::parser<list> parser_for( parsco::lang<Json>,
+                                        parsco::tag<list> ) {
+  co_return co_await bracketed_vec<value>( '[', ']' );
+}
+
+inline parsco::charset first_chars( parsco::lang<Json>,
+                                    parsco::tag<list> ) {
+  return parsco::charset( "[ \n\r\t" );
+}
+
+/****************************************************************
+** doc
+*****************************************************************/
+inline parsco::parser<doc> parser_for( parsco::lang<Json>,
+                                       parsco::tag<doc> ) {
+  using namespace parsco;
+  return emplace<doc>( parse<Json, table>() ) << blanks_sv();
+}
+
+} // namespace json
@@ -25,6 +25,9 @@
  * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
  * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#pragma once
+
+// C++ standard library
 #include <memory>
 #include <string>
 #include <string_view>
@@ -25,96 +25,19 @@
  * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
  * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include "json-model.hpp"
+#include "json-grammar.hpp"
 
 // parsco
-#include "parsco/combinator.hpp"
-#include "parsco/ext-basic.hpp"
-#include "parsco/ext-std.hpp"
-#include "parsco/promise.hpp"
 #include "parsco/runner.hpp"
 
 // C++ standard library
+#include <cassert>
 #include <iostream>
 
 using namespace std;
 using namespace parsco;
 using namespace json;
 
-// For ADL reasons, the parse_for extension point overrides for
-// the JSON model types must live in the same json namespace.
-namespace json {
-
-/****************************************************************
-** helpers
-*****************************************************************/
-template<typename T>
-parser<vector<T>> parse_vec() {
-  return interleave( [] { return blanks() >> parse<Json, T>(); },
-                     [] { return blanks() >> chr( ',' ); } );
-}
-
-template<typename T>
-parser<vector<T>> bracketed_vec( char l, char r ) {
-  return bracketed( blanks() >> chr( l ), parse_vec<T>(),
-                    blanks() >> chr( r ) );
-}
-
-/****************************************************************
-** string_val
-*****************************************************************/
-parser<string_val> parser_for( lang<Json>, tag<string_val> ) {
-  return emplace<string_val>( quoted_str() );
-}
-
-/****************************************************************
-** boolean
-*****************************************************************/
-parser<boolean> parser_for( lang<Json>, tag<boolean> ) {
-  return ( str( "true" ) >> ret( boolean{ true } ) ) |
-         ( str( "false" ) >> ret( boolean{ false } ) );
-}
-
-/****************************************************************
-** number
-*****************************************************************/
-parser<number> parser_for( lang<Json>, tag<number> ) {
-  // Delegate to variant parser, that's basically what number is.
-  co_return co_await parse<Json, variant<double, int>>();
-}
-
-/****************************************************************
-** key_val
-*****************************************************************/
-parser<key_val> parser_for( lang<Json>, tag<key_val> ) {
-  return emplace<key_val>( blanks() >> quoted_str(),
-                           blanks() >> chr( ':' ) >> blanks() >>
-                               parse<Json, value>() );
-}
-
-/****************************************************************
-** table
-*****************************************************************/
-parser<table> parser_for( lang<Json>, tag<table> ) {
-  co_return co_await bracketed_vec<key_val>( '{', '}' );
-}
-
-/****************************************************************
-** list
-*****************************************************************/
-parser<list> parser_for( lang<Json>, tag<list> ) {
-  co_return co_await bracketed_vec<value>( '[', ']' );
-}
-
-/****************************************************************
-** doc
-*****************************************************************/
-parser<doc> parser_for( lang<Json>, tag<doc> ) {
-  return emplace<doc>( parse<Json, table>() ) << blanks();
-}
-
-} // namespace json
-
 /****************************************************************
 ** main
 *****************************************************************/
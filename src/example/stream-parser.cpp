@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/ext.hpp"
+#include "parsco/stream.hpp"
+
+// C++ standard library
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace parsco;
+
+/****************************************************************
+** Grammar
+*****************************************************************/
+// A stream of double-quoted words. The chunk size below is much
+// smaller than the items, so most of them straddle the end of
+// the window and have to be parsed again with more input.
+struct Words {};
+
+struct word {
+  string text;
+};
+
+parser<word> parser_for( lang<Words>, tag<word> ) {
+  string_view text = co_await quoted_sv();
+  co_return word{ string( text ) };
+}
+
+/****************************************************************
+** main
+*****************************************************************/
+void run( string_view name, stream_reader reader ) {
+  size_t                total = 0;
+  result_t<size_t> const count = parse_stream<Words, word>(
+      name, std::move( reader ),
+      [&]( word&& w ) { total += w.text.size(); },
+      /*chunk_size=*/16 );
+  if( !count ) {
+    cout << name << ": " << count.get_error().what() << "\n";
+    return;
+  }
+  cout << name << ": " << *count << " words, " << total
+       << " chars\n";
+}
+
+void run( string_view name, string const& input ) {
+  istringstream in( input );
+  run( name, reader_for( in ) );
+}
+
+int main( int, char** ) {
+  string many;
+  for( int i = 0; i < 20; ++i ) many += "\"hello world\" ";
+  run( "many", many );
+
+  run( "long", "\"" + string( 100, 'x' ) + "\"\n\"y\"" );
+
+  // Fails, but only once the whole input has been read.
+  run( "unterminated", many + "\"hello" );
+
+  // Fails as soon as the bad item is in the window, without
+  // reading the rest.
+  string tail;
+  for( int i = 0; i < 100; ++i ) tail += many;
+  string const  bad = many + "oops " + tail;
+  istringstream in( bad );
+  size_t        read = 0;
+  run( "early", [&, r = reader_for( in )]( char*  dst,
+                                           size_t n ) {
+    size_t const k = r( dst, n );
+    if( k != stream_read_error ) read += k;
+    return k;
+  } );
+  cout << "early: read " << read << " of " << bad.size()
+       << " chars\n";
+
+  // Reading from a file descriptor that is not open fails.
+  run( "bad-fd", fd_reader( -1 ) );
+
+  return 0;
+}
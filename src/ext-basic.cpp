@@ -36,51 +36,12 @@ using namespace std;
 
 namespace parsco {
 
-namespace {
-
-result_t<int> safe_stoi( string const &s, int base = 10 ) {
-  result_t<int> res( error( "error parsing int" ) );
-  if( !s.empty() ) {
-    size_t written;
-    try {
-      auto n = ::std::stoi( s, &written, base );
-      if( written == s.size() ) res = n;
-    } catch( std::exception const & ) {}
-  }
-  return res;
-}
-
-result_t<double> safe_stod( string const &s ) {
-  result_t<double> res( error( "error parsing double" ) );
-  if( !s.empty() ) {
-    size_t written;
-    try {
-      auto d = ::std::stod( s, &written );
-      if( written == s.size() ) res = d;
-    } catch( exception const & ) {}
-  }
-  return res;
-}
-
-} // namespace
-
 parser<int> parse_int() {
-  int multiplier =
-      ( co_await try_{ chr( '-' ) } ).has_value() ? -1 : 1;
-  co_return multiplier *co_await lift(
-      safe_stoi( co_await many1( digit ) ) );
+  co_return co_await builtin_int<int>{};
 }
 
 parser<double> parse_double() {
-  double multiplier =
-      ( co_await try_{ chr( '-' ) } ).has_value() ? -1 : 1;
-  string ipart = co_await many( digit );
-  co_await chr( '.' );
-  string fpart = co_await many( digit );
-  if( ipart.empty() && fpart.empty() )
-    co_await fail( "expected double" );
-  co_return multiplier *co_await lift(
-      safe_stod( ipart + '.' + fpart ) );
+  co_return co_await builtin_float<double>{};
 }
 
 } // namespace parsco
@@ -0,0 +1,135 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/file.hpp"
+
+// C++ standard library
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if __has_include( <sys/mman.h> ) && __has_include( <unistd.h> )
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define PARSCO_HAS_MMAP 1
+#endif
+
+using namespace std;
+
+namespace parsco {
+
+namespace {
+
+error open_error( string const& path, int err ) {
+  return error( path + ": cannot open file: " +
+                strerror( err ) );
+}
+
+result_t<string> read_whole_file( string const& path ) {
+  ifstream in( path, ios::binary );
+  // Streams don't say why they failed (errno is not reliable).
+  if( !in ) return error( path + ": cannot open file." );
+  string res( istreambuf_iterator<char>( in ),
+              istreambuf_iterator<char>{} );
+  if( in.bad() )
+    return error( path + ": failed to read file." );
+  return res;
+}
+
+} // namespace
+
+/****************************************************************
+** file_buffer
+*****************************************************************/
+file_buffer::~file_buffer() noexcept { release(); }
+
+file_buffer::file_buffer( file_buffer&& rhs ) noexcept
+  : mapped_( exchange( rhs.mapped_, nullptr ) ),
+    size_( exchange( rhs.size_, 0 ) ),
+    contents_( std::move( rhs.contents_ ) ) {}
+
+file_buffer& file_buffer::operator=(
+    file_buffer&& rhs ) noexcept {
+  if( this == &rhs ) return *this;
+  release();
+  mapped_   = exchange( rhs.mapped_, nullptr );
+  size_     = exchange( rhs.size_, 0 );
+  contents_ = std::move( rhs.contents_ );
+  return *this;
+}
+
+void file_buffer::release() noexcept {
+#if defined( PARSCO_HAS_MMAP )
+  if( mapped_ != nullptr )
+    ::munmap( const_cast<char*>( mapped_ ), size_ );
+#endif
+  mapped_ = nullptr;
+  size_   = 0;
+  contents_.reset();
+}
+
+string_view file_buffer::view() const {
+  if( mapped_ != nullptr ) return string_view( mapped_, size_ );
+  if( contents_ != nullptr ) return *contents_;
+  return {};
+}
+
+result_t<file_buffer> file_buffer::open( string const& path ) {
+  file_buffer res;
+#if defined( PARSCO_HAS_MMAP )
+  int const fd = ::open( path.c_str(), O_RDONLY );
+  if( fd < 0 ) return open_error( path, errno );
+  struct stat st;
+  // Only regular, non-empty files can be mapped; for anything
+  // else fall through and read the file normally.
+  if( ::fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) &&
+      st.st_size > 0 ) {
+    void* p = ::mmap( nullptr, st.st_size, PROT_READ,
+                      MAP_PRIVATE, fd, 0 );
+    if( p != MAP_FAILED ) {
+      ::close( fd );
+      // Parsers scan forward through the buffer.
+      ::madvise( p, st.st_size, MADV_SEQUENTIAL );
+      res.mapped_ = static_cast<char const*>( p );
+      res.size_   = st.st_size;
+      return res;
+    }
+  }
+  ::close( fd );
+#endif
+  result_t<string> contents = read_whole_file( path );
+  if( !contents ) return contents.get_error();
+  res.contents_ =
+      make_unique<string const>( std::move( *contents ) );
+  return res;
+}
+
+} // namespace parsco
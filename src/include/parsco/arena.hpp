@@ -0,0 +1,284 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/stats.hpp"
+
+// C++ standard library
+#include <array>
+#include <cstddef>
+#include <new>
+#include <optional>
+
+/****************************************************************
+** Coroutine Frame Arena
+*****************************************************************/
+// Every parser is a coroutine and so every invocation of a
+// parser allocates a coroutine frame. Those frames are always
+// created and destroyed in a stack-like fashion (a parser is de-
+// stroyed by the one that awaited it) and there are typically
+// only a handful of distinct frame sizes in a given grammar, so
+// a general purpose heap allocator is overkill. The arena in
+// this module takes advantage of that.
+namespace parsco {
+
+// An allocator for coroutine frames. Memory is carved out of
+// large chunks, and freed frames are put onto a per-size-class
+// free list so that the next frame of that size can reuse them.
+// Nothing is ever returned to the system until the arena itself
+// is destroyed, at which point all chunks are freed at once.
+//
+// On top of that, the most recently freed frame is parked in a
+// recycle slot and handed straight back out if the next frame
+// has exactly the same size. That is the common case in a repe-
+// tition such as many( f ), where each iteration destroys the
+// frame of the previous call to f just before creating the next
+// one, so that the whole loop runs in a single frame's worth of
+// memory without touching the free lists.
+//
+// An arena is not thread safe; it is intended to be installed
+// (see arena_scope below) on the thread that runs the parser.
+struct frame_arena {
+  explicit frame_arena( std::size_t chunk_size = 64 * 1024 );
+  ~frame_arena() noexcept;
+
+  frame_arena( frame_arena const& ) = delete;
+  frame_arena& operator=( frame_arena const& ) = delete;
+
+  void* allocate( std::size_t size ) {
+    if( size != slot_size_ )
+      return allocate_slow( size, frames_ );
+    ++frames_;
+    ++recycled_;
+    return take_slot();
+  }
+
+  // Same as allocate, but for the nodes of a tree (see
+  // make_arena_ptr), which are counted in nodes() instead of in
+  // frames(). They are freed with deallocate.
+  void* allocate_node( std::size_t size ) {
+    if( size != slot_size_ )
+      return allocate_slow( size, nodes_ );
+    ++nodes_;
+    return take_slot();
+  }
+
+  void deallocate( void* p, std::size_t size ) noexcept {
+    if( size > kMaxFrame ) return deallocate_slow( p, size );
+    --live_;
+    if( slot_size_ != 0 ) push_free( slot_, slot_size_ );
+    slot_      = p;
+    slot_size_ = size;
+  }
+
+  // Number of frames and nodes that have been allocated from
+  // this arena and not yet freed.
+  int live() const { return live_; }
+
+  // Total number of frames that have been allocated from this
+  // arena over its lifetime.
+  std::size_t frames() const { return frames_; }
+
+  // Total number of nodes that have been allocated from this
+  // arena (via allocate_node) over its lifetime.
+  std::size_t nodes() const { return nodes_; }
+
+  // Number of those frames that were served from the recycle
+  // slot, i.e., that reused the memory of the frame freed just
+  // before them.
+  std::size_t recycled() const { return recycled_; }
+
+  // Total number of bytes that this arena has requested from the
+  // system for its chunks.
+  std::size_t reserved() const { return reserved_; }
+
+private:
+  // Frame sizes are rounded up to a multiple of the granularity
+  // to get their size class. Frames larger than the largest size
+  // class (4KB) are allocated directly on the heap.
+  static constexpr std::size_t kGranularity = 16;
+  static constexpr std::size_t kNumClasses  = 256;
+  static constexpr std::size_t kMaxFrame =
+      kGranularity * kNumClasses;
+
+  struct free_node {
+    free_node* next;
+  };
+
+  struct chunk {
+    chunk*      next;
+    std::size_t size;
+  };
+
+  // Increments `count` if the memory comes from the arena.
+  void* allocate_slow( std::size_t size, std::size_t& count );
+  void  deallocate_slow( void* p, std::size_t size ) noexcept;
+  void  new_chunk( std::size_t min_size );
+
+  void* take_slot() {
+    ++live_;
+    slot_size_ = 0;
+    return slot_;
+  }
+
+  void push_free( void* p, std::size_t size ) noexcept {
+    std::size_t const cls =
+        ( size + kGranularity - 1 ) / kGranularity;
+    auto* n          = static_cast<free_node*>( p );
+    n->next          = free_lists_[cls];
+    free_lists_[cls] = n;
+  }
+
+  std::size_t                             chunk_size_;
+  chunk*                                  chunks_     = nullptr;
+  char*                                   cur_        = nullptr;
+  char*                                   end_        = nullptr;
+  int                                     live_       = 0;
+  std::size_t                             frames_     = 0;
+  std::size_t                             nodes_      = 0;
+  std::size_t                             recycled_   = 0;
+  std::size_t                             reserved_   = 0;
+  std::array<free_node*, kNumClasses + 1> free_lists_ = {};
+  // The recycle slot; empty when slot_size_ is zero.
+  void*                                   slot_       = nullptr;
+  std::size_t                             slot_size_  = 0;
+};
+
+// Returns the arena that is currently installed on this thread,
+// or nullptr if there is none.
+frame_arena* current_arena() noexcept;
+
+// While this object is alive the given arena will be used to al-
+// locate all parser coroutine frames that are created on this
+// thread. Scopes can be nested; the previous arena is restored
+// when the scope ends.
+struct arena_scope {
+  explicit arena_scope( frame_arena& arena ) noexcept;
+  ~arena_scope() noexcept;
+
+  arena_scope( arena_scope const& ) = delete;
+  arena_scope& operator=( arena_scope const& ) = delete;
+
+private:
+  frame_arena* prev_;
+};
+
+// Guarantees that there is an arena installed for as long as
+// this object is alive: if the caller has already installed one
+// then it is reused, otherwise a fresh one is created and in-
+// stalled. This is what the parser runners use.
+struct ensure_arena {
+  ensure_arena();
+
+private:
+  // Order matters; the scope must be torn down first.
+  std::optional<frame_arena> own_;
+  std::optional<arena_scope> scope_;
+};
+
+/****************************************************************
+** Node Arena
+*****************************************************************/
+// A frame_arena can equally well hold the nodes of the tree that
+// a parser produces (see arena_ptr in ext-std.hpp). That arena
+// must outlive the parse (and the tree), and so it is separate
+// from the one for the frames, which the runners throw away when
+// the parse is done. Nothing is installed by default, in which
+// case nodes come from the heap.
+
+// Returns the arena that is currently installed on this thread
+// for nodes, or nullptr if there is none.
+frame_arena* current_node_arena() noexcept;
+
+// While this object is alive, nodes created on this thread are
+// allocated from the given arena. Scopes can be nested; the pre-
+// vious arena is restored when the scope ends.
+struct node_arena_scope {
+  explicit node_arena_scope( frame_arena& arena ) noexcept;
+  ~node_arena_scope() noexcept;
+
+  node_arena_scope( node_arena_scope const& ) = delete;
+  node_arena_scope& operator=( node_arena_scope const& ) =
+      delete;
+
+private:
+  frame_arena* prev_;
+};
+
+namespace detail {
+
+// The arena that is installed on this thread. It lives in the
+// header (and not behind current_arena) so that the frame allo-
+// cation functions below can be inlined into the parsers.
+inline constinit thread_local frame_arena* g_current_arena =
+    nullptr;
+
+inline constinit thread_local frame_arena*
+    g_current_node_arena = nullptr;
+
+// This sits in front of every coroutine frame. It is padded out
+// to the default new alignment so that the frame that follows it
+// is still suitably aligned.
+struct alignas( __STDCPP_DEFAULT_NEW_ALIGNMENT__ ) frame_header {
+  frame_arena* arena;
+  parse_stats* stats;
+};
+
+// These are what the promise type's operator new/delete forward
+// to. Each frame records the arena it came from (if any) so that
+// it can be freed correctly regardless of which arena is current
+// at the time that it is destroyed, and likewise the stats that
+// it was counted in (see stats.hpp).
+inline void* allocate_frame( std::size_t size ) {
+  frame_arena*      arena = g_current_arena;
+  parse_stats*      stats = g_current_stats;
+  std::size_t const total = size + sizeof( frame_header );
+  void*             mem   = ( arena != nullptr )
+                                  ? arena->allocate( total )
+                                  : ::operator new( total );
+  if( stats != nullptr ) stats->on_frame_created( size );
+  auto* header = ::new( mem ) frame_header{ arena, stats };
+  return header + 1;
+}
+
+inline void deallocate_frame( void*       p,
+                              std::size_t size ) noexcept {
+  auto*             header = static_cast<frame_header*>( p ) - 1;
+  std::size_t const total  = size + sizeof( frame_header );
+  if( header->stats != nullptr )
+    header->stats->on_frame_destroyed();
+  if( header->arena != nullptr )
+    header->arena->deallocate( header, total );
+  else
+    ::operator delete( header, total );
+}
+
+} // namespace detail
+
+} // namespace parsco
@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/****************************************************************
+** Character Sets
+*****************************************************************/
+namespace parsco {
+
+// A set of chars stored as a 256-bit bitmap, so that membership
+// is a single table lookup regardless of the size of the set.
+// Everything is constexpr, so sets built from literals can be
+// computed at compile time:
+//
+//   constexpr charset kHex = charset::range( '0', '9' ) |
+//                            charset( "abcdefABCDEF" );
+//
+struct charset {
+  constexpr charset() = default;
+
+  constexpr explicit charset( std::string_view chars ) {
+    for( char c : chars ) add( c );
+  }
+
+  constexpr explicit charset( char const* chars )
+    : charset( std::string_view( chars ) ) {}
+
+  // All chars in [first, last].
+  static constexpr charset range( char first, char last ) {
+    charset res;
+    for( int c = uint8_t( first ); c <= uint8_t( last ); ++c )
+      res.add( char( c ) );
+    return res;
+  }
+
+  constexpr bool contains( char c ) const {
+    uint8_t const u = uint8_t( c );
+    return ( ( bits_[u >> 6] >> ( u & 63 ) ) & 1 ) != 0;
+  }
+
+  constexpr charset& add( char c ) {
+    uint8_t const u = uint8_t( c );
+    bits_[u >> 6] |= uint64_t( 1 ) << ( u & 63 );
+    return *this;
+  }
+
+  constexpr charset operator|( charset const& rhs ) const {
+    charset res;
+    for( int i = 0; i < 4; ++i )
+      res.bits_[i] = bits_[i] | rhs.bits_[i];
+    return res;
+  }
+
+  // The complement.
+  constexpr charset operator~() const {
+    charset res;
+    for( int i = 0; i < 4; ++i ) res.bits_[i] = ~bits_[i];
+    return res;
+  }
+
+  constexpr bool operator==( charset const& ) const = default;
+
+private:
+  std::array<uint64_t, 4> bits_ = {};
+};
+
+} // namespace parsco
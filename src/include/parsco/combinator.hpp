@@ -34,10 +34,16 @@
 #include "parsco/promise.hpp"
 
 // C++ standard library
+#include <array>
+#include <bit>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <variant>
 #include <vector>
 
 // NOTE: In this module, what would otherwise be a collection of
@@ -68,11 +74,23 @@ using many_result_container_t =
 /****************************************************************
 ** Primitives
 *****************************************************************/
+// Note that the single-character parsers in this module are not
+// coroutines but "magic" awaitables (see magic.hpp) that the
+// promise runs inline. They can be used anywhere that a parser
+// can, and will convert to a parser<char> when needed.
+
 // Consumes a char that must be c, otherwise it fails.
-parser<char> chr( char c );
+builtin_chr chr( char c );
 
 // Consumes any char, fails at eof.
-parser<char> any_chr();
+builtin_next_char any_chr();
+
+// Yields the next char without consuming it, fails at eof.
+builtin_peek_char peek_char();
+
+// Yields the offset of the current position from the start of
+// the input, without consuming anything.
+builtin_position position();
 
 struct Ret {
   template<typename T>
@@ -91,32 +109,69 @@ inline constexpr Ret ret{};
 /****************************************************************
 ** Character Classes
 *****************************************************************/
+// The character classes are all backed by charsets, so that each
+// test is a table lookup.
+using char_class = builtin_one_of;
+
 // Consumes one space (' ');
-parser<char> space();
+builtin_chr space();
 // Either CR or LF.
-parser<char> crlf();
+char_class crlf();
 // '\t'
-parser<char> tab();
+builtin_chr tab();
 // One of any of the space/blank characters.
-parser<char> blank();
+char_class blank();
 
 // Consumes one digit [0-9] char or fails.
-parser<char> digit();
-
-parser<char> lower();
-parser<char> upper();
-parser<char> alpha();
-parser<char> alphanum();
-
-// Consumes one char if it is one of the ones in sv.
-parser<char> one_of( std::string sv );
-parser<char> not_of( std::string sv );
+char_class digit();
+
+char_class lower();
+char_class upper();
+char_class alpha();
+char_class alphanum();
+
+// Consumes one char if it is one of the ones in sv. The set of
+// chars is converted to a charset up front; pass a charset dir-
+// ectly to do that at compile time instead.
+builtin_one_of one_of( std::string sv );
+builtin_one_of not_of( std::string sv );
+builtin_one_of one_of( charset set );
+builtin_one_of not_of( charset set );
+
+// Consumes the longest (possibly empty) run of chars that are
+// (or are not) in the set, and never fails. This is equivalent
+// to many( one_of, ... ) but consumes the run in one step and
+// returns a view into the buffer.
+builtin_span     span_of( charset set );
+builtin_span_not span_not_of( charset set );
 
 /****************************************************************
 ** Strings
 *****************************************************************/
-// Attempts to consume the exact string, and fails otherwise.
-parser<> str( std::string sv );
+// Attempts to consume the exact string, and fails otherwise. The
+// std::string overload owns its string and so is safe to use
+// with temporaries; the others only hold a view and don't allo-
+// cate.
+parser<>    str( std::string s );
+builtin_str str( std::string_view s );
+builtin_str str( char const* s );
+
+// Same, but for a literal given as a template argument, e.g.
+// str<"true">(). This is the fastest way to match a literal.
+template<fixed_string S>
+builtin_lit<S> str() {
+  return {};
+}
+
+// Consumes the longest of the given literals that comes next and
+// returns it, e.g. co_await keyword<"true", "false">(). This is
+// much faster than trying each one in turn with first( str( ...
+// ), ... ), since the candidates are looked up by the next char.
+// Like str, this does not check what follows the keyword.
+template<fixed_string... Ks>
+builtin_keyword<Ks...> keyword() {
+  return {};
+}
 
 parser<std::string> identifier();
 
@@ -131,11 +186,65 @@ parser<std::string_view> single_quoted_str();
 // Allows either double or single quotes.
 parser<std::string> quoted_str();
 
+// These are the same as the above, but they return views into
+// the buffer instead of copying into new strings, and they are
+// magic awaitables and so don't create a coroutine frame. The
+// views are only valid for as long as the buffer being parsed.
+builtin_blanks     blanks_sv();
+builtin_identifier identifier_sv();
+builtin_quoted     quoted_sv();
+
 /****************************************************************
 ** Miscellaneous
 *****************************************************************/
 // Succeeds if the input stream is finished.
-parser<> eof();
+builtin_eof eof();
+
+/****************************************************************
+** lookahead
+*****************************************************************/
+// Runs the parser p and yields its result, but without consuming
+// anything. Fails if p fails.
+struct Lookahead {
+  template<Parser P>
+  builtin_lookahead<P> operator()( P p ) const {
+    return { std::move( p ) };
+  }
+};
+
+inline constexpr Lookahead lookahead{};
+
+/****************************************************************
+** not_followed_by
+*****************************************************************/
+// Succeeds without consuming anything if the parser p fails at
+// this point, and fails if it succeeds. E.g. str( "if" ) fol-
+// lowed by not_followed_by( alphanum() ) matches the keyword
+// but not the identifier "iffy".
+struct NotFollowedBy {
+  template<Parser P>
+  builtin_not_followed_by<P> operator()( P p ) const {
+    return { std::move( p ) };
+  }
+};
+
+inline constexpr NotFollowedBy not_followed_by{};
+
+/****************************************************************
+** skip
+*****************************************************************/
+// Runs the parser and discards its result, which is never mate-
+// rialized: the result of a parser<T> is left where it is, and a
+// discarded invoke (or emplace, seq, etc.) doesn't even call its
+// function. Which of these applies is decided by discard_traits.
+struct Skip {
+  template<Parser P>
+  auto operator()( P p ) const {
+    return detail::discarded( std::move( p ) );
+  }
+};
+
+inline constexpr Skip skip{};
 
 /****************************************************************
 ** pred
@@ -143,13 +252,11 @@ parser<> eof();
 // Parses a single character for which the predicate returns
 // true, fails otherwise.
 struct Pred {
-  // Need to take Func by value so that it stays around when this
-  // function suspends.
+  // Need to take Func by value so that it stays around until the
+  // result is awaited.
   template<typename Func>
-  parser<char> operator()( Func f ) const {
-    char next = co_await builtin_next_char{};
-    if( !f( next ) ) co_await fail();
-    co_return next;
+  builtin_pred<Func> operator()( Func f ) const {
+    return builtin_pred<Func>{ std::move( f ) };
   }
 };
 
@@ -167,20 +274,47 @@ struct Many {
   auto operator()( Func f, Args... args ) const -> parser<
       many_result_container_t<typename std::invoke_result_t<
           Func, Args...>::value_type>> {
-    using res_t =
-        typename std::invoke_result_t<Func, Args...>::value_type;
-    many_result_container_t<res_t> res;
-    while( true ) {
-      auto m = co_await try_{ f( std::move( args )... ) };
-      if( !m.has_value() ) break;
-      res.push_back( std::move( *m ) );
+    using parser_t = std::invoke_result_t<Func, Args...>;
+    using res_t    = typename parser_t::value_type;
+    if constexpr( CharBuiltin<parser_t> ) {
+      // A repetition of a single-character builtin can be con-
+      // sumed in one step by the corresponding span builtin,
+      // which is equivalent but doesn't need to loop through the
+      // promise for each char.
+      co_return std::string(
+          co_await span_for( f( std::move( args )... ) ) );
+    } else {
+      many_result_container_t<res_t> res;
+      while( true ) {
+        auto m = co_await try_{ f( std::move( args )... ) };
+        if( !m.has_value() ) break;
+        res.push_back( std::move( *m ) );
+      }
+      co_return res;
     }
-    co_return res;
   }
 };
 
 inline constexpr Many many{};
 
+/****************************************************************
+** skip_many
+*****************************************************************/
+// Same as many, but discards the results instead of collecting
+// them. `s` is either a (copyable) parser such as a builtin or a
+// function that returns a parser to run on each iteration. Un-
+// like many this also stops after an iteration that consumes
+// nothing, so a parser that can succeed on empty input (e.g.
+// blanks()) does not make it loop forever.
+struct SkipMany {
+  template<typename S>
+  builtin_skip_many<S> operator()( S s ) const {
+    return { std::move( s ) };
+  }
+};
+
+inline constexpr SkipMany skip_many{};
+
 /****************************************************************
 ** many_exhuast
 *****************************************************************/
@@ -249,20 +383,87 @@ struct Many1 {
 inline constexpr Many1 many1{};
 
 /****************************************************************
-** seq
+** many_each
 *****************************************************************/
-// Runs multiple parsers in sequence, and only succeeds if all of
-// them succeed. Returns all results in a tuple.
-struct Seq {
-  template<typename... Parsers>
-  parser<std::tuple<typename Parsers::value_type...>> operator()(
-      Parsers... ps ) const {
-    co_return std::tuple<typename Parsers::value_type...>{
-        co_await std::move( ps )... };
+// Parses zero or more of the given parser, same as many, but in-
+// stead of collecting the results it hands each one to `sink` as
+// soon as it has been parsed. Returns the number of results.
+// With this an arbitrarily long list can be processed (e.g.
+// streamed somewhere else) without ever materializing it.
+struct ManyEach {
+  // Take args by value for lifetime reasons.
+  template<typename Sink, typename Func, typename... Args>
+  parser<std::size_t> operator()( Sink sink, Func f,
+                                  Args... args ) const {
+    using parser_t = std::invoke_result_t<Func, Args...>;
+    std::size_t n  = 0;
+    if constexpr( CharBuiltin<parser_t> ) {
+      // See many.
+      std::string_view const sv =
+          co_await span_for( f( std::move( args )... ) );
+      for( char c : sv ) sink( c );
+      n = sv.size();
+    } else {
+      while( true ) {
+        auto m = co_await try_{ f( std::move( args )... ) };
+        if( !m.has_value() ) break;
+        sink( std::move( *m ) );
+        ++n;
+      }
+    }
+    co_return n;
   }
 };
 
-inline constexpr Seq seq{};
+inline constexpr ManyEach many_each{};
+
+/****************************************************************
+** many_into
+*****************************************************************/
+// Same as many, but appends the results to the given container
+// (using push_back) instead of returning a new one. This way the
+// caller can reserve capacity up front when it has an idea of
+// how many results there will be, reuse a container from one
+// parse to the next, or use some other kind of container. The
+// container must outlive the parser.
+struct ManyInto {
+  template<typename Container, typename Func, typename... Args>
+  parser<> operator()( Container& c, Func f,
+                       Args... args ) const {
+    auto sink = [&]( auto&& e ) {
+      c.push_back( std::forward<decltype( e )>( e ) );
+    };
+    (void)co_await many_each( sink, std::move( f ),
+                              std::move( args )... );
+  }
+};
+
+inline constexpr ManyInto many_into{};
+
+/****************************************************************
+** many_fold
+*****************************************************************/
+// Parses zero or more of the given parser and combines the re-
+// sults as they are parsed, starting from `init`, i.e. for each
+// result r: acc = op( std::move( acc ), std::move( r ) ). Re-
+// turns the final value. This is for reductions (e.g. summing a
+// list of numbers) that need no container at all.
+struct ManyFold {
+  template<typename T, typename Op, typename Func,
+           typename... Args>
+  parser<T> operator()( T init, Op op, Func f,
+                        Args... args ) const {
+    auto sink = [&]( auto&& e ) {
+      init = op( std::move( init ),
+                 std::forward<decltype( e )>( e ) );
+    };
+    (void)co_await many_each( sink, std::move( f ),
+                              std::move( args )... );
+    co_return std::move( init );
+  }
+};
+
+inline constexpr ManyFold many_fold{};
 
 /****************************************************************
 ** invoke
@@ -273,53 +474,18 @@ inline constexpr Seq seq{};
 // NOTE: the parsers are guaranteed to be run in the order they
 // appear in the parameter list, and that is one of the benefits
 // of using this helper.
+//
+// This does not create a coroutine; the parsers are run by the
+// promise of whichever parser awaits the result (see builtin_-
+// invoke). When the result is instead converted to a parser<T>,
+// the return value of the function is constructed in place in
+// that parser's result.
 struct Invoke {
   // Take func by value for lifetime reasons.
-  // clang-format off
-  template<size_t... Idx, typename Func, typename... Parsers>
-  parser<std::invoke_result_t<Func,
-                              typename Parsers::value_type...>>
-  run( std::index_sequence<Idx...>, Func func,
-       Parsers... ps ) const {
-    // clang-format on
-    // We can't simply do the following:
-    //
-    //   co_return T( co_await std::move( ps )... );
-    //
-    // because then we'd be depending on the order of evaluation
-    // of function arguments. So we have to use a fold expression
-    // with the comma operator, which apparently guarantees eval-
-    // uation order, see:
-    //
-    //   https://stackoverflow.com/questions/46056268/
-    //                order-of-evaluation-for-fold-expressions
-    //
-    // Use std::optional so that the parser result types do not
-    // need to be default constructible.
-    std::tuple<std::optional<typename Parsers::value_type>...>
-        res_tpl;
-
-    auto run_parser = [&]<size_t I>(
-                          std::integral_constant<size_t, I>,
-                          auto&& p ) -> parser<> {
-      std::get<I>( res_tpl ).emplace( co_await std::move( p ) );
-    };
-    // Here is the fold expression whose order of evaluation is
-    // supposed to be well-defined because we are using the comma
-    // operator.
-    ( co_await run_parser( std::integral_constant<size_t, Idx>{},
-                           std::move( ps ) ),
-      ... );
-
-    std::tuple<typename Parsers::value_type&&...> ref_tpl{
-        std::move( *std::get<Idx>( res_tpl ) )... };
-    co_return std::apply( func, ref_tpl );
-  }
-
   template<typename Func, typename... Parsers>
-  auto operator()( Func&& func, Parsers... ps ) const {
-    return run( std::index_sequence_for<Parsers...>(),
-                std::forward<Func>( func ), std::move( ps )... );
+  builtin_invoke<Func, Parsers...> operator()(
+      Func func, Parsers... ps ) const {
+    return { std::move( func ), { std::move( ps )... } };
   }
 };
 
@@ -328,52 +494,88 @@ inline constexpr Invoke invoke{};
 /****************************************************************
 ** emplace
 *****************************************************************/
+namespace detail {
+
+template<typename T>
+struct construct {
+  template<typename... Args>
+  T operator()( Args&&... args ) const {
+    return T( std::forward<Args>( args )... );
+  }
+};
+
+} // namespace detail
+
 // Calls the constructor of the given type with the results of
-// the parsers as arguments (which must all succeed).
+// the parsers as arguments (which must all succeed). See invoke.
 template<typename T>
 struct Emplace {
   template<typename... Parsers>
-  parser<T> operator()( Parsers... ps ) const {
-    auto applier = []( auto&&... args ) {
-      return T( std::move( args )... );
-    };
-    return invoke( applier, std::move( ps )... );
+  builtin_invoke<detail::construct<T>, Parsers...> operator()(
+      Parsers... ps ) const {
+    return invoke( detail::construct<T>{}, std::move( ps )... );
   }
 };
 
 template<typename T>
 inline constexpr Emplace<T> emplace{};
 
+/****************************************************************
+** seq
+*****************************************************************/
+// Runs multiple parsers in sequence, and only succeeds if all of
+// them succeed. Returns all results in a tuple.
+struct Seq {
+  template<typename... Parsers>
+  auto operator()( Parsers... ps ) const {
+    return emplace<std::tuple<typename Parsers::value_type...>>(
+        std::move( ps )... );
+  }
+};
+
+inline constexpr Seq seq{};
+
 /****************************************************************
 ** seq_last
 *****************************************************************/
 namespace detail {
 
-template<typename T>
-struct select_tag {
-  using type = T;
-};
-
-// Use a fold-expression to fold the comma operator over the pa-
-// rameter pack.
 template<typename... Ts>
 using select_last_t =
-    typename decltype( ( detail::select_tag<Ts>{}, ... ) )::type;
+    std::tuple_element_t<sizeof...( Ts ) - 1, std::tuple<Ts...>>;
+
+// Hands back its last argument.
+struct select_last {
+  template<typename... Ts>
+  std::remove_cvref_t<select_last_t<Ts...>> operator()(
+      Ts&&... args ) const {
+    return std::move(
+        std::get<sizeof...( Ts ) - 1>( std::tie( args... ) ) );
+  }
+};
+
+// Idx indexes all but the last of ps.
+template<std::size_t... Idx, typename... Parsers>
+auto seq_last_impl( std::index_sequence<Idx...>,
+                    Parsers... ps ) {
+  std::tuple<Parsers...> t( std::move( ps )... );
+  return invoke(
+      select_last{},
+      discarded( std::move( std::get<Idx>( t ) ) )...,
+      std::move( std::get<sizeof...( Idx )>( t ) ) );
+}
 
 } // namespace detail
 
 // Runs multiple parsers in sequence, and only succeeds if all of
-// them succeed. Returns last result.
+// them succeed. Returns last result; the others are discarded
+// (see skip) and so are never materialized.
 struct SeqLast {
-  template<typename... Parsers>
-  parser<typename detail::select_last_t<Parsers...>::value_type>
-  operator()( Parsers... ps ) const {
-    using ret_t =
-        typename detail::select_last_t<Parsers...>::value_type;
-    if constexpr( std::is_same_v<ret_t, std::monostate> )
-      ( co_await std::move( ps ), ... );
-    else
-      co_return( co_await std::move( ps ), ... );
+  template<typename P, typename... Parsers>
+  auto operator()( P p, Parsers... ps ) const {
+    return detail::seq_last_impl(
+        std::index_sequence_for<Parsers...>{}, std::move( p ),
+        std::move( ps )... );
   }
 };
 
@@ -382,15 +584,25 @@ inline constexpr SeqLast seq_last{};
 /****************************************************************
 ** seq_first
 *****************************************************************/
+namespace detail {
+
+// Hands back its first argument.
+struct select_first {
+  template<typename T, typename... Ts>
+  std::remove_cvref_t<T> operator()( T&& fst, Ts&&... ) const {
+    return std::move( fst );
+  }
+};
+
+} // namespace detail
+
 // Runs multiple parsers in sequence, and only succeeds if all of
-// them succeed. Returns first result.
+// them succeed. Returns first result; the others are discarded.
 struct SeqFirst {
   template<typename Parser, typename... Parsers>
-  parser<typename Parser::value_type> operator()(
-      Parser fst, Parsers... ps ) const {
-    auto res = co_await std::move( fst );
-    ( (void)co_await std::move( ps ), ... );
-    co_return res;
+  auto operator()( Parser fst, Parsers... ps ) const {
+    return invoke( detail::select_first{}, std::move( fst ),
+                   detail::discarded( std::move( ps ) )... );
   }
 };
 
@@ -401,7 +613,25 @@ inline constexpr SeqFirst seq_first{};
 *****************************************************************/
 struct OnError {
   template<Parser P>
-  P operator()( P p, std::string msg ) const {
+  parser<typename P::value_type> operator()(
+      P p, std::string msg ) const {
+    auto res = co_await try_{ std::move( p ) };
+    if( res.has_value() ) co_return *res;
+    co_await fail( std::string_view( msg ) );
+    parsco::unreachable();
+  }
+
+  template<Parser P>
+  parser<typename P::value_type> operator()(
+      P p, char const* msg ) const {
+    return ( *this )( std::move( p ), std::string( msg ) );
+  }
+
+  // Same as above, but avoids copying the message when this
+  // fails.
+  template<Parser P>
+  parser<typename P::value_type> operator()(
+      P p, static_text msg ) const {
     auto res = co_await try_{ std::move( p ) };
     if( res.has_value() ) co_return *res;
     co_await fail( msg );
@@ -428,7 +658,8 @@ inline constexpr OnError on_error{};
 // error message.
 struct Diagnose {
   template<Parser P1, Parser P2>
-  P1 operator()( P1 p1, P2 expected ) const {
+  parser<typename P1::value_type> operator()(
+      P1 p1, P2 expected ) const {
     auto res = co_await std::move( p1 );
     // Parser has succeeded, now test EOF.
     if( co_await try_{ eof() } )
@@ -438,9 +669,9 @@ struct Diagnose {
     (void)co_await std::move( expected );
     // p2 succeeded but ideally shouldn't have, so we'll just
     // fail it manually.
-    co_await fail(
+    co_await fail( static_text(
         "parsing partially succeeded but was not able to "
-        "consume all input." );
+        "consume all input." ) );
     parsco::unreachable();
   }
 };
@@ -452,14 +683,23 @@ inline constexpr Diagnose diagnose{};
 *****************************************************************/
 // Runs the given parser and then checks that the input buffers
 // has been exhausted (if not, it fails). Returns the result from
-// the parser.
+// the parser, if it has one.
 struct Exhaust {
-  template<typename T>
-  parser<T> operator()( parser<T> p ) const {
-    T res = co_await std::move( p );
+  template<Parser P>
+  parser<typename P::value_type> operator()( P p ) const {
+    typename P::value_type res = co_await std::move( p );
     co_await eof();
     co_return res;
   }
+
+  // A parser<> has nothing to co_return.
+  template<Parser P>
+  requires( std::is_same_v<typename P::value_type,
+                           std::monostate> )
+  parser<> operator()( P p ) const {
+    co_await std::move( p );
+    co_await eof();
+  }
 };
 
 inline constexpr Exhaust exhaust{};
@@ -474,7 +714,7 @@ struct Lift {
   template<typename T>
   parser<std::remove_cvref_t<decltype( *std::declval<T>() )>>
   operator()( T o ) const {
-    if( !o ) co_await fail( o.get_error().what() );
+    if( !o ) co_await fail( std::move( o.get_error() ) );
     co_return *std::move( o );
   }
 
@@ -492,19 +732,20 @@ inline constexpr Lift lift{};
 *****************************************************************/
 // Runs the parser p between characters l and r.
 struct Bracketed {
-  template<typename T>
-  parser<T> operator()( char l, parser<T> p, char r ) const {
+  template<Parser P>
+  parser<typename P::value_type> operator()( char l, P p,
+                                             char r ) const {
     co_await chr( l );
-    T res = co_await std::move( p );
+    typename P::value_type res = co_await std::move( p );
     co_await chr( r );
     co_return res;
   }
 
-  template<typename L, typename R, typename T>
-  parser<T> operator()( parser<L> l, parser<T> p,
-                        parser<R> r ) const {
+  template<Parser L, Parser P, Parser R>
+  parser<typename P::value_type> operator()( L l, P p,
+                                             R r ) const {
     (void)co_await std::move( l );
-    T res = co_await std::move( p );
+    typename P::value_type res = co_await std::move( p );
     (void)co_await std::move( r );
     co_return std::move( res );
   }
@@ -515,11 +756,13 @@ inline constexpr Bracketed bracketed{};
 /****************************************************************
 ** try_ignore
 *****************************************************************/
-// Try the parse but ignore the result if it succeeds.
+// Try the parse but ignore the result if it succeeds. The result
+// is never materialized (see skip).
 struct TryIgnore {
   template<Parser P>
-  parser<> operator()( P p ) const {
-    (void)co_await try_{ std::move( p ) };
+  auto operator()( P p ) const {
+    return builtin_try_skip{
+        detail::discarded( std::move( p ) ) };
   }
 };
 
@@ -543,40 +786,166 @@ struct Fmap {
 
 inline constexpr Fmap fmap{};
 
+/****************************************************************
+** spanned
+*****************************************************************/
+// A value along with the range of the input that it was parsed
+// from, as offsets from the start of the input ([begin, end)).
+template<typename T>
+struct located {
+  T   value;
+  int begin = 0;
+  int end   = 0;
+};
+
+namespace detail {
+
+template<typename T>
+struct make_located {
+  located<T> operator()( int begin, T&& value, int end ) const {
+    return located<T>{ .value = std::move( value ),
+                       .begin = begin,
+                       .end   = end };
+  }
+};
+
+} // namespace detail
+
+// Runs the parser p and yields its result along with the offsets
+// of where it started and ended. Nothing is copied from the in-
+// put, and like invoke this does not create a coroutine of its
+// own.
+struct Spanned {
+  template<Parser P, typename T = typename P::value_type>
+  builtin_invoke<detail::make_located<T>, builtin_position, P,
+                 builtin_position>
+  operator()( P p ) const {
+    return invoke( detail::make_located<T>{}, position(),
+                   std::move( p ), position() );
+  }
+};
+
+inline constexpr Spanned spanned{};
+
 /****************************************************************
 ** First
 *****************************************************************/
 // Runs the parsers in sequence until the first one succeeds,
 // then returns its result (all of the parsers must return the
 // same result type). If none of them succeed then the parser
-// fails.
+// fails. This is a builtin_first, which the promise runs in
+// place, so alternatives made of builtins cost no frames.
 struct First {
   // clang-format off
   template<typename P, typename... Ps>
   requires( std::is_same_v<typename P::value_type,
                            typename Ps::value_type> && ...)
-  parser<typename P::value_type> operator()( P fst,
-                                             Ps... rest ) const {
+  builtin_first<P, Ps...> operator()( P fst, Ps... rest ) const {
     // clang-format on
-    using res_t = typename P::value_type;
-    std::optional<res_t> res;
-
-    auto one = [&]<typename T>( parser<T> p ) -> parser<> {
-      if( res.has_value() ) co_return;
-      auto exp = co_await try_{ std::move( p ) };
-      if( !exp.has_value() ) co_return;
-      res.emplace( std::move( *exp ) );
-    };
-    co_await one( std::move( fst ) );
-    ( co_await one( std::move( rest ) ), ... );
-
-    if( !res.has_value() ) co_await fail();
-    co_return std::move( *res );
+    return { { std::move( fst ), std::move( rest )... } };
   }
 };
 
 inline constexpr First first{};
 
+/****************************************************************
+** dispatch
+*****************************************************************/
+namespace detail {
+
+// Tries the alternatives (in order) that `mask_fn` says can
+// start with the next char (see next_char_alternatives), where
+// alternative i is the parser returned by make( i ). The last
+// one is run directly, so that it gets to report the error if it
+// fails.
+template<typename R>
+struct DispatchRun {
+  template<typename MaskFn, typename Make>
+  parser<R> operator()( MaskFn mask_fn, Make make ) const {
+    std::uint64_t mask = co_await next_char_alternatives<MaskFn>{
+        std::move( mask_fn ) };
+    while( true ) {
+      int const i = std::countr_zero( mask );
+      mask &= mask - 1;
+      if( mask == 0 ) co_return co_await make( i );
+      auto res = co_await try_{ make( i ) };
+      if( res.has_value() ) co_return std::move( *res );
+    }
+  }
+};
+
+template<typename R>
+inline constexpr DispatchRun<R> dispatch_run{};
+
+} // namespace detail
+
+// An alternative for dispatch: the parser returned by `f` is
+// only tried when the next char is in `first`.
+template<typename Func>
+struct dispatch_alt {
+  charset first;
+  Func    f;
+};
+
+template<typename Func>
+dispatch_alt<Func> alt( charset first, Func f ) {
+  return dispatch_alt<Func>{ first, std::move( f ) };
+}
+
+// Predictive alternation: the same as first( fs()... ), except
+// that only the alternatives whose FIRST set contains the next
+// char are tried. When those sets don't overlap, this goes
+// straight to the one alternative that can match instead of cre-
+// ating and failing all of the ones before it. When they do
+// overlap the candidates are tried in order, as with first. An
+// alternative with a full set (~charset()) is always a candi-
+// date, and is the only kind that is tried at EOF.
+struct Dispatch {
+  // clang-format off
+  template<typename Func, typename... Funcs>
+  requires( std::is_same_v<
+      typename std::invoke_result_t<Func>::value_type,
+      typename std::invoke_result_t<Funcs>::value_type> && ... )
+  auto operator()( dispatch_alt<Func> a,
+                   dispatch_alt<Funcs>... as ) const {
+    // clang-format on
+    using res_t =
+        typename std::invoke_result_t<Func>::value_type;
+    static_assert( sizeof...( Funcs ) < 64,
+                   "too many alternatives." );
+    std::array<charset, 1 + sizeof...( Funcs )> const firsts{
+        a.first, as.first... };
+    auto mask_fn = [firsts]( int c ) {
+      std::uint64_t res = 0;
+      for( std::size_t i = 0; i < firsts.size(); ++i ) {
+        bool const viable =
+            ( c < 0 ) ? ( firsts[i] == ~charset() )
+                      : firsts[i].contains( char( c ) );
+        if( viable ) res |= std::uint64_t( 1 ) << i;
+      }
+      return res;
+    };
+    auto make = [alts = std::tuple{ std::move( a ),
+                                    std::move( as )... }](
+                    int i ) {
+      std::optional<parser<res_t>> res;
+      std::apply(
+          [&]( auto const&... alt ) {
+            int j = 0;
+            ( ( j++ == i ? (void)res.emplace( alt.f() )
+                         : (void)0 ),
+              ... );
+          },
+          alts );
+      return std::move( *res );
+    };
+    return detail::dispatch_run<res_t>( std::move( mask_fn ),
+                                        std::move( make ) );
+  }
+};
+
+inline constexpr Dispatch dispatch{};
+
 /****************************************************************
 ** interleave_first
 *****************************************************************/
@@ -632,21 +1001,54 @@ struct Interleave {
   auto operator()( F f, G g, bool sep_required = true ) const
       -> parser<many_result_container_t<
           typename std::invoke_result_t<F>::value_type>> {
-    auto container =
-        co_await interleave_last( f, g, sep_required );
-    if( sep_required )
-      // If the separator was not required then the above call to
-      // interleave_last will have already picked up the last
-      // f(). If the separate is required then the above will
-      // have either parsed nothing or will have ended by parsing
-      // a separator, in which case we need to parse one more f.
+    if( !sep_required )
+      // This will pick up the last f() as well.
+      co_return co_await interleave_last( f, g, false );
+    // Each f() is parsed once; going by pairs of f g and then
+    // parsing one more f would parse the last one twice, which
+    // is exponential in the nesting depth when f is recursive.
+    many_result_container_t<
+        typename std::invoke_result_t<F>::value_type>
+        container;
+    container.push_back( co_await f() );
+    while( true ) {
+      auto sep = co_await try_{ g() };
+      if( !sep.has_value() ) break;
       container.push_back( co_await f() );
+    }
     co_return container;
   }
 };
 
 inline constexpr Interleave interleave{};
 
+/****************************************************************
+** interleave_into
+*****************************************************************/
+// Same as interleave, but appends the f's to the given container
+// instead of returning a new one; see many_into.
+struct InterleaveInto {
+  template<typename Container, typename F, typename G>
+  // Take functions by value for lifetime reasons.
+  parser<> operator()( Container& c, F f, G g,
+                       bool sep_required = true ) const {
+    if( !sep_required ) {
+      co_await many_into(
+          c, [&] { return seq_first( f(), try_{ g() } ); } );
+      co_return;
+    }
+    // Parses each f() once; see interleave.
+    c.push_back( co_await f() );
+    while( true ) {
+      auto sep = co_await try_{ g() };
+      if( !sep.has_value() ) break;
+      c.push_back( co_await f() );
+    }
+  }
+};
+
+inline constexpr InterleaveInto interleave_into{};
+
 /****************************************************************
 ** cat
 *****************************************************************/
@@ -666,23 +1068,60 @@ inline constexpr Cat cat{};
 /****************************************************************
 ** Haskell-like sequencing operator
 *****************************************************************/
+// These produce builtins that the promise runs in place (see
+// seq_last, seq_first and first), so an expression made of them
+// only becomes a coroutine where it is converted to a parser<T>.
+// A chain such as a >> b >> c is flattened into one builtin as
+// it is built, so that it runs as one straight sequence.
+
 // Run the parsers in sequence (all must succeed) and return the
 // result of the final one.
 template<Parser T, Parser U>
-parser<typename U::value_type> operator>>( T l, U r ) {
+auto operator>>( T l, U r ) {
   return seq_last( std::move( l ), std::move( r ) );
 }
 
+template<typename... Ps, Parser U>
+auto operator>>( builtin_invoke<detail::select_last, Ps...> l,
+                 U r ) {
+  return std::apply(
+      [&]( Ps&... ps ) {
+        return seq_last( std::move( ps )..., std::move( r ) );
+      },
+      l.parsers );
+}
+
 // Run the parsers in sequence (all must succeed) and return the
 // result of the first one.
 template<Parser T, Parser U>
-parser<typename T::value_type> operator<<( T l, U r ) {
+auto operator<<( T l, U r ) {
   return seq_first( std::move( l ), std::move( r ) );
 }
 
+template<typename... Ps, Parser U>
+auto operator<<( builtin_invoke<detail::select_first, Ps...> l,
+                 U r ) {
+  return std::apply(
+      [&]( Ps&... ps ) {
+        return seq_first( std::move( ps )..., std::move( r ) );
+      },
+      l.parsers );
+}
+
+// Run the parsers in order until one succeeds and return its
+// result (both must return the same type).
 template<Parser T, Parser U>
-parser<typename U::value_type> operator|( T l, U r ) {
+auto operator|( T l, U r ) {
   return first( std::move( l ), std::move( r ) );
 }
 
+template<typename... Ps, Parser U>
+auto operator|( builtin_first<Ps...> l, U r ) {
+  return std::apply(
+      [&]( Ps&... ps ) {
+        return first( std::move( ps )..., std::move( r ) );
+      },
+      l.parsers );
+}
+
 } // namespace parsco
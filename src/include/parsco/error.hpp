@@ -27,29 +27,133 @@
  */
 #pragma once
 
+// parsco
+#include "parsco/stats.hpp"
+
 // C++ standard library
+#include <cstddef>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace parsco {
 
 /****************************************************************
 ** Parser Error/Result
 *****************************************************************/
+// Text that outlives anything that refers to it, i.e. a string
+// literal or other text with static storage duration. An error
+// made from one holds just the pointer. The constructor only ac-
+// cepts constant arrays, so it can't be given e.g. the c_str()
+// of a temporary:
+//
+//   co_await fail( static_text( "expected a digit" ) );
+//
+struct static_text {
+  template<std::size_t N>
+  consteval static_text( char const ( &s )[N] ) noexcept
+    : text( s ) {}
+
+  // For a pointer that is known to point to static text, e.g.
+  // one of the messages that the builtins pick at runtime.
+  static constexpr static_text assume_static(
+      char const* s ) noexcept {
+    return static_text( s, 0 );
+  }
+
+  char const* text;
+
+private:
+  constexpr static_text( char const* s, int ) noexcept
+    : text( s ) {}
+};
+
+enum class error_code : unsigned char {
+  // No message.
+  none,
+  // Free-form message.
+  message,
+  // "expected <text>", e.g. "expected identifier".
+  expected,
+  // "expected '<c>'".
+  expected_char,
+  // Ran out of input.
+  eof,
+};
+
+// Failing is a normal part of parsing, e.g. it is how `many`
+// finds the end of a repetition and how `first` moves on to the
+// next alternative, and almost all errors are thrown away with-
+// out ever being looked at. So an error does not hold a format-
+// ted message, but rather a code and the pieces needed to for-
+// mat one (static text and/or a char), and so creating and copy-
+// ing one does not allocate. The message is only formatted when
+// what() is called, which the parser runners do once at the end
+// of a failed parse.
+//
+// Any other message, including a plain char const*, is copied
+// to the heap (once; copies of the error share it). Prefer
+// static text (see static_text) where possible.
+//
+// Each error that is created with a message of some kind counts
+// towards the errors in the current parse_stats (see stats.hpp).
 struct error {
-  explicit error() : msg_( "" ) {}
-  explicit error( std::string_view m ) : msg_( m ) {}
+  error() noexcept = default;
+
+  // Holds only the pointer.
+  explicit error( static_text text ) noexcept
+    : code_( error_code::message ), text_( text.text ) {
+    detail::count_error();
+  }
+
+  // Copies the text, since there is no telling how long it
+  // lives; use static_text in order to avoid that.
+  explicit error( char const* text )
+    : error( std::string( text ) ) {}
+
+  explicit error( std::string msg );
+  explicit error( std::string_view msg )
+    : error( std::string( msg ) ) {}
+
+  // "expected " + what, where `what` must be static text.
+  static error expected( char const* what ) noexcept {
+    error e;
+    e.code_ = error_code::expected;
+    e.text_ = what;
+    detail::count_error();
+    return e;
+  }
+
+  static error expected_char( char c ) noexcept {
+    error e;
+    e.code_ = error_code::expected_char;
+    e.c_    = c;
+    detail::count_error();
+    return e;
+  }
 
-  template<typename... Args>
-  explicit error( std::string_view m ) : msg_( m ) {}
+  static error eof() noexcept {
+    error e;
+    e.code_ = error_code::eof;
+    detail::count_error();
+    return e;
+  }
+
+  error_code code() const noexcept { return code_; }
 
-  std::string const& what() const { return msg_; }
+  // Formats the message.
+  std::string what() const;
 
-  operator std::string() const { return msg_; }
+  operator std::string() const { return what(); }
 
 private:
-  std::string msg_;
+  error_code  code_ = error_code::none;
+  char        c_    = 0;
+  char const* text_ = nullptr;
+  // Only for messages that were built at runtime.
+  std::shared_ptr<std::string const> owned_;
 };
 
 // Until we have std::expected<T>...
@@ -62,6 +166,7 @@ struct result_t {
   // clang-format on
 
   result_t( error const& e ) : err( e ) {}
+  result_t( error&& e ) : err( std::move( e ) ) {}
 
   template<typename... Ts>
   void emplace( Ts&&... ts ) {
@@ -88,11 +193,42 @@ struct result_t {
 };
 
 // Helper for translating character position in buffer to
-// line/col for error messages.
+// line/col for error messages. For a one-off lookup; when there
+// are several positions to find in the same buffer use a
+// line_index instead.
 struct ErrorPos {
   static ErrorPos from_index( std::string_view in, int idx );
   int             line;
   int             col;
 };
 
+// Finds the line/col of any number of positions in one buffer.
+// The offsets of the newlines are found (with memchr) the first
+// time that they are needed and kept in a sorted list, so that
+// each lookup after that is a binary search. The scan only goes
+// as far as the farthest position looked up so far, so a single
+// lookup costs no more than ErrorPos::from_index.
+//
+// The buffer must outlive the index.
+struct line_index {
+  explicit line_index( std::string_view in ) : in_( in ) {}
+
+  // Same result as ErrorPos::from_index( buffer, idx ).
+  ErrorPos pos_of( int idx );
+
+private:
+  // Makes sure that newlines_ has all newlines before idx.
+  void scan_to( int idx );
+
+  std::string_view in_;
+  // Offsets of all of the newlines before scanned_.
+  std::vector<int> newlines_;
+  int              scanned_ = 0;
+};
+
+// Formats an error the way that the parser runners report them,
+// e.g. "file.txt:error:3:5 expected identifier".
+std::string format_error( std::string_view filename,
+                          ErrorPos pos, error const& e );
+
 } // namespace parsco
\ No newline at end of file
@@ -0,0 +1,310 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/concepts.hpp"
+#include "parsco/magic.hpp"
+#include "parsco/parser.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <concepts>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/****************************************************************
+** Events
+*****************************************************************/
+// Instead of building a result, a grammar can report what it
+// parses as a stream of events, SAX style: emit( name, p ) re-
+// ports the beginning and end of a subtree (e.g. a JSON table)
+// around p, and emit_scalar( name, p ) reports a leaf along with
+// its text. The events go to an event_handler, by way of the
+// event_sink installed by run_parser_events (see runner.hpp),
+// which also takes a path_filter: the subtrees that the filter
+// rules out are skipped without delivering anything, and if the
+// grammar gives emit a skipper then they are not even parsed.
+// The rules of such a grammar return nothing, so that the memory
+// used does not depend on the size of the input.
+//
+// Events are delivered as soon as they are parsed, so like re-
+// cover, emit should only be used where the grammar has com-
+// mitted; if an enclosing alternative fails and backtracks then
+// the handler will have seen events for input that is then
+// parsed again (and a begin without its end). The exception is
+// parallel_many, whose regions record their events on whichever
+// thread they run on; those are then delivered in input order
+// on the calling thread once all of the regions are done.
+namespace parsco {
+
+// Receives the events. Names and texts are views into the input
+// (or into the grammar), valid for as long as the input is.
+struct event_handler {
+  virtual ~event_handler() = default;
+
+  virtual void begin( std::string_view /*name*/ ) {}
+  virtual void end( std::string_view /*name*/ ) {}
+  virtual void scalar( std::string_view /*name*/,
+                       std::string_view /*text*/ ) {}
+};
+
+// Selects subtrees by their paths, i.e., the names of the emits
+// that enclose them, outermost first. A pattern is a path with
+// its names separated by '/', where a name of * matches any
+// name, e.g. "address/city" or "history/*". A subtree is deliv-
+// ered along with everything in it if its path starts with one
+// of the patterns (the empty pattern matches everything); the
+// begin and end of the subtrees that lead to one are delivered
+// as well. A default-constructed filter lets everything through.
+struct path_filter {
+  path_filter() = default;
+  explicit path_filter(
+      std::vector<std::string_view> const& patterns );
+
+  enum class match {
+    // Neither on nor leading to any of the patterns.
+    none,
+    // Leads to one of the patterns.
+    ancestor,
+    // On or inside of one of the patterns.
+    inside
+  };
+
+  match check( std::span<std::string_view const> path ) const;
+
+private:
+  bool                                  everything_ = true;
+  std::vector<std::vector<std::string>> patterns_;
+};
+
+// Keeps the events that it receives in order to deliver them
+// later, e.g. those of a region of parallel_many, which might be
+// parsed on another thread.
+struct event_recorder : event_handler {
+  void begin( std::string_view name ) override;
+  void end( std::string_view name ) override;
+  void scalar( std::string_view name,
+               std::string_view text ) override;
+
+  // Delivers the recorded events to `to`, in order.
+  void replay( event_handler& to ) const;
+
+private:
+  enum class kind { begin, end, scalar };
+
+  struct event {
+    kind             k;
+    std::string_view name;
+    std::string_view text = {};
+  };
+
+  std::vector<event> events_;
+};
+
+// The state of the events of one parse. The path that it keeps
+// only goes down as far as the first subtree that is delivered
+// with everything in it, so its size is bounded by the patterns.
+struct event_sink {
+  event_sink( event_handler& handler, path_filter filter );
+
+  // A sink for a part of the input that is parsed apart from the
+  // rest but nested inside of it (see parallel_many), which
+  // starts out where `outer` is in the paths and delivers to
+  // `handler`, typically an event_recorder; see merge.
+  event_sink( event_sink const& outer, event_handler& handler );
+
+  event_sink( event_sink const& ) = delete;
+  event_sink& operator=( event_sink const& ) = delete;
+
+  // How emit is to treat a subtree.
+  enum class subtree { skipped, ancestor, wanted };
+
+  // These are called by emit around each subtree; `finished` is
+  // false when the subtree failed to parse, in which case no end
+  // is delivered.
+  subtree enter( std::string_view name );
+  void    leave( subtree s, std::string_view name,
+                 bool finished );
+
+  // Whether a scalar with this name would be delivered.
+  bool wants_scalar( std::string_view name );
+
+  void scalar( std::string_view name, std::string_view text ) {
+    handler_->scalar( name, text );
+  }
+
+  // The number of subtrees and scalars that were skipped.
+  int skipped() const { return skipped_; }
+
+  // Takes in a sink that was created as above for a part of the
+  // parse, delivering the events that it recorded in `events` to
+  // the handler of this one.
+  void merge( event_sink const&     part,
+              event_recorder const& events );
+
+private:
+  event_handler*                handler_;
+  path_filter                   filter_;
+  std::vector<std::string_view> path_;
+  // How many levels deep we are inside of a skipped (or else a
+  // wanted) subtree, counting it.
+  int muted_   = 0;
+  int wanted_  = 0;
+  int skipped_ = 0;
+};
+
+// Returns the event sink that is currently installed on this
+// thread, or nullptr if there is none.
+event_sink* current_event_sink() noexcept;
+
+// While this object is alive, the emits that run on this thread
+// deliver their events to the given sink.
+struct event_scope {
+  explicit event_scope( event_sink& sink ) noexcept;
+  ~event_scope() noexcept;
+
+  event_scope( event_scope const& ) = delete;
+  event_scope& operator=( event_scope const& ) = delete;
+
+private:
+  event_sink* prev_;
+};
+
+namespace detail {
+
+// Enters a subtree for as long as it is alive.
+struct subtree_guard {
+  subtree_guard( event_sink& sink, std::string_view name )
+    : sink_( sink ),
+      name_( name ),
+      kind_( sink.enter( name ) ) {}
+
+  ~subtree_guard() { sink_.leave( kind_, name_, finished_ ); }
+
+  subtree_guard( subtree_guard const& ) = delete;
+  subtree_guard& operator=( subtree_guard const& ) = delete;
+
+  bool wanted() const {
+    return kind_ != event_sink::subtree::skipped;
+  }
+
+  void finish() { finished_ = true; }
+
+private:
+  event_sink&         sink_;
+  std::string_view    name_;
+  event_sink::subtree kind_;
+  bool                finished_ = false;
+};
+
+} // namespace detail
+
+/****************************************************************
+** emit
+*****************************************************************/
+// Runs p as a subtree with the given name, delivering a begin
+// before and an end after it. When the subtree is filtered out
+// then p is still run (so that the input is checked), but skip-
+// ping its result and any events from inside of it; when a
+// skipper is given then it is run instead of p, so that a fast
+// scanner (e.g. one built out of span_not_of) can step over the
+// subtree without parsing it. The skipper is given either as a
+// copyable parser or as a function that returns one (see de-
+// tail::fresh), so that nothing is created for it unless it is
+// needed. Without an event sink installed this just runs p.
+struct Emit {
+  template<Parser P>
+  parser<> operator()( std::string_view name, P p ) const {
+    event_sink* const sink = current_event_sink();
+    if( sink == nullptr ) {
+      co_await skip( std::move( p ) );
+      co_return;
+    }
+    detail::subtree_guard guard( *sink, name );
+    co_await skip( std::move( p ) );
+    guard.finish();
+  }
+
+  template<Parser P, typename S>
+  parser<> operator()( std::string_view name, P p,
+                       S skipper ) const {
+    event_sink* const sink = current_event_sink();
+    if( sink == nullptr ) {
+      co_await skip( std::move( p ) );
+      co_return;
+    }
+    detail::subtree_guard guard( *sink, name );
+    if( guard.wanted() )
+      co_await skip( std::move( p ) );
+    else
+      co_await skip( detail::fresh( skipper ) );
+    guard.finish();
+  }
+};
+
+inline constexpr Emit emit{};
+
+/****************************************************************
+** emit_scalar
+*****************************************************************/
+// Runs p and delivers a scalar with the given name whose text is
+// the result of p if that is a string_view (such as the contents
+// of a quoted_sv), or else the input that p consumed. When the
+// scalar is filtered out then p is just skipped.
+struct EmitScalar {
+  template<Parser P>
+  parser<> operator()( std::string_view name, P p ) const {
+    event_sink* const sink = current_event_sink();
+    if( sink == nullptr || !sink->wants_scalar( name ) ) {
+      co_await skip( std::move( p ) );
+      co_return;
+    }
+    if constexpr( std::same_as<typename P::value_type,
+                               std::string_view> ) {
+      std::string_view const text = co_await std::move( p );
+      sink->scalar( name, text );
+    } else {
+      detail::cursor const before =
+          co_await detail::get_cursor{};
+      co_await skip( std::move( p ) );
+      detail::cursor const after = co_await detail::get_cursor{};
+      int const consumed =
+          int( after.rest.data() - before.rest.data() );
+      sink->scalar( name, before.rest.substr( 0, consumed ) );
+    }
+  }
+};
+
+inline constexpr EmitScalar emit_scalar{};
+
+} // namespace parsco
@@ -28,7 +28,14 @@
 #pragma once
 
 // parsco
+#include "parsco/charset.hpp"
 #include "parsco/ext.hpp"
+#include "parsco/magic.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <concepts>
+#include <type_traits>
 
 namespace parsco {
 
@@ -36,15 +43,47 @@ namespace parsco {
 parser<int>    parse_int();
 parser<double> parse_double();
 
+namespace detail {
+
+// The types for which there are numeric builtins.
+template<typename T>
+concept BuiltinInteger =
+    std::same_as<T, int> || std::same_as<T, long> ||
+    std::same_as<T, long long> ||
+    std::same_as<T, unsigned int> ||
+    std::same_as<T, unsigned long> ||
+    std::same_as<T, unsigned long long>;
+
+template<typename T>
+concept BuiltinFloat =
+    std::same_as<T, float> || std::same_as<T, double>;
+
+} // namespace detail
+
 // Assume that this will work the same way for any language.
-template<typename Lang>
-parser<int> parser_for( lang<Lang>, tag<int> ) {
-  return parse_int();
+template<typename Lang, detail::BuiltinInteger T>
+parser<T> parser_for( lang<Lang>, tag<T> ) {
+  return builtin_int<T>{};
+}
+
+template<typename Lang, detail::BuiltinFloat T>
+parser<T> parser_for( lang<Lang>, tag<T> ) {
+  return builtin_float<T>{};
+}
+
+// The FIRST sets of the above (see ext.hpp).
+template<typename Lang, detail::BuiltinInteger T>
+charset first_chars( lang<Lang>, tag<T> ) {
+  charset const digits = charset::range( '0', '9' );
+  if constexpr( std::is_signed_v<T> )
+    return digits | charset( "-" );
+  else
+    return digits;
 }
 
-template<typename Lang>
-parser<double> parser_for( lang<Lang>, tag<double> ) {
-  return parse_double();
+template<typename Lang, detail::BuiltinFloat T>
+charset first_chars( lang<Lang>, tag<T> ) {
+  return charset::range( '0', '9' ) | charset( "-." );
 }
 
 } // namespace parsco
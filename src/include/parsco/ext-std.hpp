@@ -28,12 +28,19 @@
 #pragma once
 
 // parsco
+#include "parsco/arena.hpp"
+#include "parsco/charset.hpp"
+#include "parsco/combinator.hpp"
 #include "parsco/ext.hpp"
 #include "parsco/promise.hpp"
 
 // C++ standard library
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <optional>
+#include <utility>
 #include <variant>
 
 namespace parsco {
@@ -59,11 +66,148 @@ parser<std::unique_ptr<T>> parser_for(
   return unique_ptr_parser<Lang, T>();
 }
 
+template<typename Lang, typename T>
+requires HasFirstChars<Lang, T>
+charset first_chars( lang<Lang>, tag<std::unique_ptr<T>> ) {
+  return first_chars( lang<Lang>{}, tag<T>{} );
+}
+
+/****************************************************************
+** arena_ptr
+*****************************************************************/
+// Deletes an object that was created by make_arena_ptr: the ob-
+// ject is destroyed, and its memory is handed back to the arena
+// that it came from, or to the heap if it did not come from one.
+template<typename T>
+struct arena_delete {
+  void operator()( T* p ) const noexcept {
+    if( arena == nullptr ) {
+      delete p;
+      return;
+    }
+    p->~T();
+    arena->deallocate( p, sizeof( T ) );
+  }
+
+  frame_arena* arena = nullptr;
+};
+
+// Like a std::unique_ptr, but the object lives in the node arena
+// that was installed (see node_arena_scope in arena.hpp) when it
+// was created, if any. A large tree made of these is then laid
+// out in a few chunks of memory instead of being scattered over
+// the heap. The arena must outlive the pointer.
+template<typename T>
+using arena_ptr = std::unique_ptr<T, arena_delete<T>>;
+
+template<typename T, typename... Args>
+arena_ptr<T> make_arena_ptr( Args&&... args ) {
+  static_assert( alignof( T ) <=
+                 __STDCPP_DEFAULT_NEW_ALIGNMENT__ );
+  frame_arena* const arena = current_node_arena();
+  if( arena == nullptr )
+    return arena_ptr<T>(
+        new T( std::forward<Args>( args )... ) );
+  void* mem = arena->allocate_node( sizeof( T ) );
+  T*    p   = nullptr;
+  // Don't leak the memory if the constructor throws.
+  try {
+    p = ::new( mem ) T( std::forward<Args>( args )... );
+  } catch( ... ) {
+    arena->deallocate( mem, sizeof( T ) );
+    throw;
+  }
+  return arena_ptr<T>( p, arena_delete<T>{ arena } );
+}
+
+template<typename Lang, typename T>
+struct ParserForArenaPtr {
+  parser<arena_ptr<T>> operator()() const {
+    co_return make_arena_ptr<T>( co_await parse<Lang, T>() );
+  }
+};
+
+template<typename Lang, typename T>
+inline constexpr ParserForArenaPtr<Lang, T> arena_ptr_parser{};
+
+template<typename Lang, typename T>
+parser<arena_ptr<T>> parser_for( lang<Lang>,
+                                 tag<arena_ptr<T>> ) {
+  return arena_ptr_parser<Lang, T>();
+}
+
+template<typename Lang, typename T>
+requires HasFirstChars<Lang, T>
+charset first_chars( lang<Lang>, tag<arena_ptr<T>> ) {
+  return first_chars( lang<Lang>{}, tag<T>{} );
+}
+
 /****************************************************************
 ** variant
 *****************************************************************/
+namespace detail {
+
+// For a variant whose alternatives declare their FIRST sets (see
+// ext.hpp): entry c is the set of alternatives that can start
+// with the char c, with the last entry being for EOF. Those that
+// don't declare one are taken to be able to start with anything,
+// including nothing.
+template<typename Lang, typename... Args>
+std::array<std::uint64_t, 257> const& variant_first_table() {
+  static std::array<std::uint64_t, 257> const table = [] {
+    std::array<std::uint64_t, 257> res = {};
+    std::size_t                    i   = 0;
+    auto add = [&]<typename Alt>( Alt* ) {
+      std::uint64_t const bit = std::uint64_t( 1 ) << i++;
+      if constexpr( HasFirstChars<Lang, Alt> ) {
+        charset const first =
+            first_chars( lang<Lang>{}, tag<Alt>{} );
+        for( int c = 0; c < 256; ++c )
+          if( first.contains( char( c ) ) ) res[c] |= bit;
+      } else {
+        for( std::uint64_t& m : res ) m |= bit;
+      }
+    };
+    ( add( (Args*)nullptr ), ... );
+    return res;
+  }();
+  return table;
+}
+
+} // namespace detail
+
+// The alternatives are tried in order, except that when any of
+// them declare their FIRST sets (see ext.hpp) then only the ones
+// that can start with the next char are tried (see dispatch).
 template<typename Lang>
 struct VariantParser {
+  template<typename... Args>
+  requires( ( HasFirstChars<Lang, Args> || ... ) &&
+            sizeof...( Args ) <= 64 )
+  parser<std::variant<Args...>> operator()(
+      tag<std::variant<Args...>> ) const {
+    using res_t = std::variant<Args...>;
+    auto mask_fn = []( int c ) {
+      return detail::variant_first_table<Lang, Args...>()[(
+          c < 0 ) ? 256 : c];
+    };
+    auto make = []( int i ) {
+      std::optional<parser<res_t>> res;
+      int                          j = 0;
+      auto one = [&]<typename Alt>( Alt* ) {
+        if( j++ != i ) return;
+        auto wrap = []( Alt&& a ) {
+          return res_t( std::in_place_type<Alt>,
+                        std::move( a ) );
+        };
+        res.emplace( invoke( wrap, parse<Lang, Alt>() ) );
+      };
+      ( one( (Args*)nullptr ), ... );
+      return std::move( *res );
+    };
+    return detail::dispatch_run<res_t>( mask_fn, make );
+  }
+
   template<typename... Args>
   parser<std::variant<Args...>> operator()(
       tag<std::variant<Args...>> ) const {
@@ -28,7 +28,12 @@
 #pragma once
 
 // parsco
+#include "parsco/charset.hpp"
 #include "parsco/parser.hpp"
+#include "parsco/profile.hpp"
+
+// C++ standard library
+#include <concepts>
 
 /****************************************************************
 ** Extension point.
@@ -43,7 +48,30 @@ struct tag {};
 
 template<typename Lang, typename T>
 parser<T> parse() {
+#if defined( PARSCO_PROFILE )
+  return detail::to_parser( named( detail::type_name<T>(),
+                                   parser_for( lang<Lang>{},
+                                               tag<T>{} ) ) );
+#else
   return parser_for( lang<Lang>{}, tag<T>{} );
+#endif
 }
 
+// Optionally, alongside parser_for, a type can declare the set
+// of chars that the input can start with when it parses as that
+// type (its FIRST set):
+//
+//   charset first_chars( lang<Lang>, tag<T> );
+//
+// This allows alternations over T (e.g. a std::variant) to jump
+// straight to the alternatives that can match the next char in-
+// stead of trying each one in turn (see dispatch). Only declare
+// this for types whose parsers can't succeed without consuming
+// anything.
+template<typename Lang, typename T>
+concept HasFirstChars = requires {
+  { first_chars( lang<Lang>{}, tag<T>{} ) }
+    -> std::convertible_to<charset>;
+};
+
 } // namespace parsco
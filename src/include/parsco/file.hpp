@@ -0,0 +1,79 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/error.hpp"
+
+// C++ standard library
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/****************************************************************
+** File Buffers
+*****************************************************************/
+namespace parsco {
+
+// Holds the entire contents of a file in memory. Where possible
+// (POSIX) the file is memory-mapped, so that there is no copy
+// and pages are only brought in as the parser reaches them. Oth-
+// erwise (or for things like pipes that can't be mapped) the
+// file is read into a string, which is kept on the heap.
+//
+// The view is valid for as long as the file_buffer is alive, and
+// remains valid when the file_buffer is moved.
+struct file_buffer {
+  file_buffer() = default;
+  ~file_buffer() noexcept;
+
+  file_buffer( file_buffer&& rhs ) noexcept;
+  file_buffer& operator=( file_buffer&& rhs ) noexcept;
+
+  file_buffer( file_buffer const& ) = delete;
+  file_buffer& operator=( file_buffer const& ) = delete;
+
+  static result_t<file_buffer> open( std::string const& path );
+
+  std::string_view view() const;
+
+  bool is_mapped() const { return mapped_ != nullptr; }
+
+private:
+  void release() noexcept;
+
+  // Exactly one of these is used. The string is behind a point-
+  // er so that its chars don't move with the file_buffer (which
+  // they would if they fit in the small string buffer).
+  char const*                        mapped_ = nullptr;
+  std::size_t                        size_   = 0;
+  std::unique_ptr<std::string const> contents_;
+};
+
+} // namespace parsco
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+/****************************************************************
+** Fixed Strings
+*****************************************************************/
+namespace parsco {
+
+// A string literal that can be passed as a template argument,
+// e.g. str<"true">(), so that the parser knows it (and its
+// length) at compile time. The null terminator is not counted
+// in the size.
+template<std::size_t N>
+struct fixed_string {
+  constexpr fixed_string( char const ( &s )[N + 1] ) {
+    std::copy_n( s, N + 1, chars );
+  }
+
+  static constexpr std::size_t size() { return N; }
+
+  constexpr std::string_view view() const {
+    return std::string_view( chars, N );
+  }
+
+  // Needs to be public in order for this to be usable as a tem-
+  // plate parameter.
+  char chars[N + 1] = {};
+};
+
+template<std::size_t M>
+fixed_string( char const ( & )[M] ) -> fixed_string<M - 1>;
+
+} // namespace parsco
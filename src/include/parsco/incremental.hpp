@@ -0,0 +1,104 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/arena.hpp"
+#include "parsco/error.hpp"
+#include "parsco/memo.hpp"
+#include "parsco/runner.hpp"
+
+// C++ standard library
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/****************************************************************
+** Incremental Parsing
+*****************************************************************/
+// For inputs that are parsed over and over again with small ed-
+// its in between, such as a document open in an editor. The
+// memo table (see memo.hpp) is kept from one parse to the next,
+// and on each edit only the entries for the rules that looked at
+// the edited range are dropped; entries after it are shifted
+// over. So when the input is reparsed, every memoized rule out-
+// side of the edit is replayed from the table instead of being
+// run again, and only the rules that enclose the edit need to
+// run.
+//
+// This only helps for rules that are memoized, i.e. that are
+// parsed via memo<Lang, T>(). Also, since results are replayed
+// across edits, they must not refer to the input (e.g. by hold-
+// ing string_views into it). Offsets are fine: a rule that reads
+// a position (e.g. via position or spanned) is not replayed
+// after an edit that shifts it.
+namespace parsco {
+
+template<typename Lang, typename T>
+struct incremental_parser {
+  incremental_parser( std::string filename, std::string text )
+    : filename_( std::move( filename ) ),
+      text_( std::move( text ) ) {
+    table_.set_buffer( text_ );
+  }
+
+  incremental_parser( incremental_parser const& ) = delete;
+  incremental_parser& operator=( incremental_parser const& ) =
+      delete;
+
+  std::string const& text() const { return text_; }
+
+  // The stats accumulate over all parses.
+  memo_table const& table() const { return table_; }
+
+  // Parses all of the current text, as in parse_from_string.
+  result_t<T> parse() {
+    arena_scope arena( arena_ );
+    memo_scope  memo( table_ );
+    table_.set_buffer( text_ );
+    return parse_from_string<Lang, T>( filename_, text_ );
+  }
+
+  // Replaces the `removed` chars at `offset` with `inserted`.
+  // Returns the number of memoized results that were dropped.
+  std::size_t edit( std::size_t offset, std::size_t removed,
+                    std::string_view inserted ) {
+    assert( offset + removed <= text_.size() );
+    text_.replace( offset, removed, inserted );
+    return table_.apply_edit( offset, removed, inserted.size() );
+  }
+
+private:
+  std::string filename_;
+  std::string text_;
+  frame_arena arena_;
+  memo_table  table_;
+};
+
+} // namespace parsco
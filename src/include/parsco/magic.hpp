@@ -27,19 +27,35 @@
  */
 #pragma once
 
+#include "parsco/charset.hpp"
 #include "parsco/concepts.hpp"
 #include "parsco/error.hpp"
+#include "parsco/fixed-string.hpp"
+#include "parsco/parser.hpp"
 
 // C++ standard library
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
-#define PROMISE_BUILTIN( name )                  \
-  struct builtin_##name {                        \
-    using value_type = std::string_view;         \
-    std::optional<BuiltinParseResult> try_parse( \
-        std::string_view in ) const;             \
+#define PROMISE_BUILTIN( name )                      \
+  struct builtin_##name {                            \
+    using value_type = std::string_view;             \
+    std::optional<BuiltinParseResult> try_parse(     \
+        std::string_view in ) const;                 \
+    bool failed_at_end( std::string_view in ) const; \
+    operator parser<std::string_view>() const {      \
+      return detail::to_parser( *this );             \
+    }                                                \
   }
 
 /****************************************************************
@@ -70,6 +86,10 @@ struct try_ {
 struct [[nodiscard]] fail_wrapper {
   using value_type = std::monostate;
   fail_wrapper()   = default;
+  // Doesn't copy the message.
+  fail_wrapper( static_text msg ) : err( msg ) {}
+  // These copy the message.
+  fail_wrapper( char const* msg ) : err( msg ) {}
   fail_wrapper( std::string_view msg ) : err( msg ) {}
   fail_wrapper( error&& e ) : err( std::move( e ) ) {}
   error err;
@@ -82,6 +102,262 @@ inline fail_wrapper fail( Ts&&... os ) {
   return fail_wrapper( std::forward<Ts>( os )... );
 }
 
+namespace detail {
+
+// Wraps one of the magic awaitables in a coroutine in order to
+// produce an owning parser object. Defined in promise.hpp.
+template<typename B>
+parser<typename B::value_type> to_parser( B b );
+
+} // namespace detail
+
+/****************************************************************
+** Single-Character Builtins
+*****************************************************************/
+// These look at (at most) the next character in the buffer and
+// either consume it or fail. The promise handles them inline, so
+// unlike a parser<char> they don't require a coroutine frame. In
+// order to still be usable where an owning parser is needed
+// (e.g. to store one in a variable), they are all implicitly
+// convertible to parser<char>.
+template<typename T>
+concept CharBuiltin = requires( T const& b, char c ) {
+  { b.accepts( c ) } -> std::convertible_to<bool>;
+  // The error that results when `c` is not accepted.
+  { b.mismatch( c ) } -> std::same_as<error>;
+};
+
+// This gets the next character from the buffer and fails if
+// there are no more characters.
+struct builtin_next_char {
+  using value_type = char;
+
+  bool  accepts( char ) const { return true; }
+  error mismatch( char ) const { return error{}; }
+
+  operator parser<char>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+// Consumes the next character if it is `c`, fails otherwise.
+struct builtin_chr {
+  using value_type = char;
+
+  bool  accepts( char next ) const { return next == c; }
+  error mismatch( char ) const {
+    return error::expected_char( c );
+  }
+
+  operator parser<char>() const {
+    return detail::to_parser( *this );
+  }
+
+  char c;
+};
+
+// Consumes the next character if the predicate returns true for
+// it, fails otherwise.
+template<typename Func>
+struct builtin_pred {
+  using value_type = char;
+
+  bool  accepts( char next ) const { return f( next ); }
+  error mismatch( char ) const { return error{}; }
+
+  operator parser<char>() const {
+    return detail::to_parser( *this );
+  }
+
+  Func f;
+};
+
+// Consumes the next character if it is in `set`, fails other-
+// wise.
+struct builtin_one_of {
+  using value_type = char;
+
+  bool accepts( char next ) const {
+    return set.contains( next );
+  }
+  error mismatch( char ) const { return error{}; }
+
+  operator parser<char>() const {
+    return detail::to_parser( *this );
+  }
+
+  charset set;
+};
+
+/****************************************************************
+** Span Builtins
+*****************************************************************/
+// These consume the longest (possibly empty) run of chars that
+// are accepted, and return a view of it. They never fail. As
+// with the single-character builtins, they are run directly on
+// the buffer in one step.
+template<typename T>
+concept SpanBuiltin = requires( T const& b, char c ) {
+  requires std::same_as<typename T::value_type,
+                        std::string_view>;
+  { b.accepts( c ) } -> std::convertible_to<bool>;
+};
+
+// A run of chars that are in `set`.
+struct builtin_span {
+  using value_type = std::string_view;
+
+  bool accepts( char next ) const {
+    return set.contains( next );
+  }
+
+  operator parser<std::string_view>() const {
+    return detail::to_parser( *this );
+  }
+
+  charset set;
+};
+
+// A run of chars that are not in `set`.
+struct builtin_span_not {
+  using value_type = std::string_view;
+
+  bool accepts( char next ) const {
+    return !set.contains( next );
+  }
+
+  operator parser<std::string_view>() const {
+    return detail::to_parser( *this );
+  }
+
+  charset set;
+};
+
+// A run of chars that are each accepted by the single-character
+// builtin `b`. This is what `many` uses on builtins that aren't
+// backed by a charset.
+template<CharBuiltin B>
+struct builtin_span_while {
+  using value_type = std::string_view;
+
+  bool accepts( char next ) const { return b.accepts( next ); }
+
+  operator parser<std::string_view>() const {
+    return detail::to_parser( *this );
+  }
+
+  B b;
+};
+
+// Returns the span builtin that consumes what a repetition of
+// the single-character builtin `b` would.
+inline builtin_span span_for( builtin_one_of const& b ) {
+  return builtin_span{ b.set };
+}
+
+template<CharBuiltin B>
+builtin_span_while<B> span_for( B b ) {
+  return builtin_span_while<B>{ std::move( b ) };
+}
+
+/****************************************************************
+** String Builtins
+*****************************************************************/
+// Consumes the exact string `s`, fails otherwise. The string is
+// compared against the buffer directly, so nothing is copied or
+// allocated. Note that this only holds a view; the characters
+// must outlive the awaitable, which is always the case for lit-
+// erals. For a string that does not live long enough, use the
+// owning `str( std::string )` overload instead.
+struct builtin_str {
+  using value_type = std::monostate;
+
+  operator parser<>() const {
+    return detail::to_parser( *this );
+  }
+
+  std::string_view s;
+};
+
+// Same as builtin_str, but for a string that is known at compile
+// time (see str<"...">()), which lets the comparison against the
+// buffer be done in one go.
+template<fixed_string S>
+struct builtin_lit {
+  static_assert( S.size() > 0, "empty literal." );
+
+  using value_type = std::monostate;
+
+  operator parser<>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+// Consumes the longest of the given keywords that the buffer
+// starts with and returns it (as a view of the keyword, not of
+// the buffer), or fails if there is none. The keywords that can
+// match are looked up by the first char of the buffer in a table
+// built at compile time, so at most those are compared.
+template<fixed_string... Ks>
+struct builtin_keyword {
+  static constexpr std::size_t kCount = sizeof...( Ks );
+  static_assert( kCount > 0 && kCount <= 64,
+                 "need between 1 and 64 keywords." );
+  static_assert( ( ( Ks.size() > 0 ) && ... ),
+                 "empty keyword." );
+
+  using value_type = std::string_view;
+
+  operator parser<std::string_view>() const {
+    return detail::to_parser( *this );
+  }
+
+  // The keywords sorted by decreasing length, so that trying
+  // them in this order finds the longest match first.
+  static constexpr std::array<std::string_view, kCount>
+      kByLength = [] {
+        std::array<std::string_view, kCount> res{ Ks.view()... };
+        // Insertion sort; it needs to be stable so that the or-
+        // der given is kept among keywords of the same length.
+        for( std::size_t i = 1; i < kCount; ++i )
+          for( std::size_t j = i;
+               j > 0 && res[j - 1].size() < res[j].size(); --j )
+            std::swap( res[j - 1], res[j] );
+        return res;
+      }();
+
+  // Bit i of kFirst[c] is set if kByLength[i] starts with c.
+  static constexpr std::array<std::uint64_t, 256> kFirst = [] {
+    std::array<std::uint64_t, 256> res = {};
+    for( std::size_t i = 0; i < kCount; ++i )
+      res[std::uint8_t( kByLength[i][0] )] |= std::uint64_t( 1 )
+                                              << i;
+    return res;
+  }();
+
+  // What is reported when nothing matches, e.g. "one of 'true',
+  // 'false'". This is computed up front so that failing does not
+  // need to format anything.
+  static constexpr auto kExpected = [] {
+    constexpr std::string_view kPrefix = "one of ";
+    constexpr std::size_t      kSize =
+        kPrefix.size() + ( ( Ks.size() + 4 ) + ... ) - 2;
+    std::array<char, kSize + 1> res = {};
+    std::size_t                 n   = 0;
+    auto append = [&]( std::string_view s ) {
+      for( char c : s ) res[n++] = c;
+    };
+    append( kPrefix );
+    for( std::string_view k : { Ks.view()... } ) {
+      if( n > kPrefix.size() ) append( ", " );
+      append( "'" );
+      append( k );
+      append( "'" );
+    }
+    return res;
+  }();
+};
+
 /****************************************************************
 ** Builtin Parsers
 *****************************************************************/
@@ -94,15 +370,411 @@ struct BuiltinParseResult {
   int consumed;
 };
 
-// This gets the next character from the buffer and fails if
-// there are no more characters.
-struct builtin_next_char {
-  using value_type = char;
-};
-
+// For each of these, failed_at_end tells, given an input on
+// which try_parse failed, whether it only failed because it ran
+// out of input (e.g. a quoted string with no closing quote).
 PROMISE_BUILTIN( blanks );
 PROMISE_BUILTIN( identifier );
 PROMISE_BUILTIN( single_quoted );
 PROMISE_BUILTIN( double_quoted );
+// Either double or single quoted.
+PROMISE_BUILTIN( quoted );
+
+/****************************************************************
+** Numeric Builtins
+*****************************************************************/
+// The result of scanning a number at the start of the buffer.
+// If `err` is not null then the scan failed (or the number was
+// out of range for T) and `err` describes why. `at_end` is set
+// if the scan ran into the end of the buffer, i.e., if more in-
+// put could have changed the outcome either way; it is never set
+// for an integer that is out of range, since that is final.
+template<typename T>
+struct NumberParseResult {
+  T           val      = {};
+  int         consumed = 0;
+  char const* err      = nullptr;
+  bool        at_end   = false;
+};
+
+// Parses an integer (with a leading '-' if T is signed) and
+// converts it in place with std::from_chars. For base 16 an op-
+// tional 0x/0X prefix is allowed, as long as it is followed by a
+// digit (otherwise the 0 is the number). A number that does not
+// fit in T is an error. The supported types are the standard
+// signed and unsigned int, long, and long long.
+template<typename T>
+struct builtin_int {
+  using value_type = T;
+
+  NumberParseResult<T> try_parse( std::string_view in ) const;
+
+  operator parser<T>() const {
+    return detail::to_parser( *this );
+  }
+
+  int base = 10;
+};
+
+// Parses a floating point number of the form [-]d*.d*[e[+-]d+]
+// or [-]d+e[+-]d+, where at least one digit is required in the
+// mantissa. Either a decimal point or an exponent is required,
+// so that a plain integer does not parse as a floating point
+// number; this allows e.g. variant<double, int> to work as ex-
+// pected. Hexadecimal numbers are written as in C, i.e.,
+// [-]0xh*.h*[p[+-]d+] with the same requirements, where the ex-
+// ponent is a power of two. A number that is out of range for T
+// is an error. The supported types are float and double.
+template<typename T>
+struct builtin_float {
+  using value_type = T;
+
+  NumberParseResult<T> try_parse( std::string_view in ) const;
+
+  operator parser<T>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+/****************************************************************
+** Buffer Builtins
+*****************************************************************/
+// The result of running a buffer builtin (see below). On suc-
+// cess `consumed` chars are removed from the buffer. Either way,
+// `farthest` is the farthest position (relative to the start of
+// the buffer) that was looked at, which is where errors get re-
+// ported.
+template<typename T>
+struct BufferParseResult {
+  result_t<T> res;
+  int         consumed = 0;
+  int         farthest = 0;
+};
+
+// A builtin that is handed all of the remaining buffer at once
+// and decides for itself how much of it to consume. This is for
+// combinators that need to run parsers in some way other than
+// awaiting them, e.g. on other threads (see parallel.hpp). If
+// `run` can also take an int after the buffer then it is given
+// the offset of the buffer in the input as well, so that any
+// parsers that it runs can be told where they are (see
+// position).
+template<typename B>
+concept BufferBuiltin = requires( B const& b,
+                                  std::string_view in ) {
+  typename B::value_type;
+  { b.run( in ) } -> std::same_as<
+      BufferParseResult<typename B::value_type>>;
+};
+
+namespace detail {
+
+// A buffer builtin that looks at (but does not consume) the
+// next char and returns the set of alternatives that can start
+// with it, as a bitmask computed by `mask` (which is given -1 at
+// EOF). Fails if there are none, in which case the char counts
+// as looked at. This is what predictive alternation (see dis-
+// patch) is built on.
+template<typename MaskFn>
+struct next_char_alternatives {
+  using value_type = std::uint64_t;
+
+  BufferParseResult<std::uint64_t> run(
+      std::string_view in ) const {
+    int const c = in.empty() ? -1 : std::uint8_t( in[0] );
+    std::uint64_t const m = mask( c );
+    if( m != 0 ) return { .res = m };
+    if( in.empty() ) return { .res = error::eof() };
+    return { .res = error(), .farthest = 1 };
+  }
+
+  MaskFn mask;
+};
+
+// A buffer builtin that consumes the next n chars, or as many as
+// there are left if that is fewer. Never fails.
+struct skip_chars {
+  using value_type = std::monostate;
+
+  BufferParseResult<std::monostate> run(
+      std::string_view in ) const {
+    int const k = std::clamp( n, 0, int( in.size() ) );
+    return { .res      = std::monostate{},
+             .consumed = k,
+             .farthest = k };
+  }
+
+  int n = 0;
+};
+
+/****************************************************************
+** Cursor and Probing
+*****************************************************************/
+// These give a combinator a look at where the parser that awaits
+// them is in the input, which is needed e.g. for error recovery
+// (see recover.hpp).
+
+// What get_cursor yields.
+struct cursor {
+  // The input that the awaiting parser has not consumed yet.
+  std::string_view rest;
+  // The farthest position that the awaiting parser has looked at
+  // so far, relative to the start of `rest`.
+  int farthest = 0;
+};
+
+// Yields the cursor of the awaiting parser. Never fails.
+struct get_cursor {
+  using value_type = cursor;
+};
+
+// Runs the parser and yields whether it succeeded. Never fails
+// and never consumes anything, though what the parser looked at
+// counts as having been looked at.
+template<typename U>
+struct probe {
+  using value_type = bool;
+  parser<U> p;
+};
+
+} // namespace detail
+
+/****************************************************************
+** Position
+*****************************************************************/
+// Yields the offset of the current position from the start of
+// the input. Never fails and consumes nothing. This is just a
+// read of the promise's own state; the promises pass down the
+// offset at which each child parser starts for this purpose.
+struct builtin_position {
+  using value_type = int;
+
+  operator parser<int>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+/****************************************************************
+** Lookahead
+*****************************************************************/
+// These look at the input without consuming any of it, though
+// what they look at counts as having been looked at for the
+// purpose of error positions. The promise checks the buffer (or
+// runs the parser) directly, so none of them needs a coroutine
+// frame of its own.
+
+// Yields the next char without consuming it. Fails at eof.
+struct builtin_peek_char {
+  using value_type = char;
+
+  operator parser<char>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+// Succeeds if there is no more input.
+struct builtin_eof {
+  using value_type = std::monostate;
+
+  operator parser<>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+// Runs p and yields its result, but then puts back whatever it
+// consumed. Fails if p fails.
+template<Parser P>
+struct builtin_lookahead {
+  using value_type = typename P::value_type;
+
+  operator parser<value_type>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  P p;
+};
+
+// Succeeds, consuming nothing, if p fails; fails if p succeeds.
+template<Parser P>
+struct builtin_not_followed_by {
+  using value_type = std::monostate;
+
+  operator parser<>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  P p;
+};
+
+/****************************************************************
+** Invoke
+*****************************************************************/
+// Runs the parsers in order (all must succeed) and then calls
+// `func` with their results. The promise runs the parsers it-
+// self, so this needs no coroutine frame of its own, and when it
+// is converted to a parser<value_type> the result of `func` is
+// constructed directly in that parser's result slot instead of
+// being moved there. This is what invoke, emplace and seq pro-
+// duce.
+template<typename Func, typename... Ps>
+struct builtin_invoke {
+  using value_type =
+      std::invoke_result_t<Func, typename Ps::value_type...>;
+
+  operator parser<value_type>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  Func              func;
+  std::tuple<Ps...> parsers;
+};
+
+/****************************************************************
+** Alternatives
+*****************************************************************/
+// Runs the parsers in order until one of them succeeds, and
+// yields its result. As with invoke, the promise runs them it-
+// self, so that a chain of alternatives made of builtins runs
+// without creating any coroutine frames. This is what first and
+// operator| produce.
+template<typename P, typename... Ps>
+struct builtin_first {
+  using value_type = typename P::value_type;
+
+  operator parser<value_type>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  std::tuple<P, Ps...> parsers;
+};
+
+/****************************************************************
+** Skipping
+*****************************************************************/
+// Runs p for its effect on the input only. The promise runs it
+// in place (as with invoke) and never takes its result: that of
+// a parser<T> is left in the child's frame, and only the number
+// of chars consumed is applied.
+template<Parser P>
+struct builtin_skip {
+  using value_type = std::monostate;
+
+  operator parser<>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  P p;
+};
+
+// Same as builtin_skip, but p is allowed to fail, in which case
+// nothing is consumed.
+template<Parser P>
+struct builtin_try_skip {
+  using value_type = std::monostate;
+
+  operator parser<>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  P p;
+};
+
+namespace detail {
+
+// For combinators that run a parser repeatedly. `s` is either a
+// copyable parser (such as a builtin) or a function that returns
+// one, and this returns a fresh parser from it.
+template<typename S>
+auto fresh( S const& s ) {
+  if constexpr( std::invocable<S const&> )
+    return s();
+  else
+    return S( s );
+}
+
+} // namespace detail
+
+// Runs the parser given by `s` (see detail::fresh) until it
+// fails, or until it succeeds without consuming anything, skip-
+// ping what it consumes. A single-character builtin is run as
+// the corresponding span builtin. Never fails.
+template<typename S>
+struct builtin_skip_many {
+  using value_type = std::monostate;
+
+  operator parser<>() const {
+    return detail::to_parser( *this );
+  }
+
+  S s;
+};
+
+// The discard trait: what to await in place of a P whose result
+// is not going to be used. By default that is P under a
+// builtin_skip, but a builtin can specialize this when it has a
+// cheaper way of doing nothing with its result.
+template<typename P>
+struct discard_traits {
+  static builtin_skip<P> discard( P p ) {
+    return { std::move( p ) };
+  }
+};
+
+namespace detail {
+
+template<typename P>
+auto discarded( P p ) {
+  return discard_traits<P>::discard( std::move( p ) );
+}
+
+// Calls nothing.
+struct ignore_all {
+  template<typename... Ts>
+  std::monostate operator()( Ts&&... ) const {
+    return {};
+  }
+};
+
+} // namespace detail
+
+// These already have no result.
+template<typename P>
+struct discard_traits<builtin_skip<P>> {
+  static builtin_skip<P> discard( builtin_skip<P> p ) {
+    return p;
+  }
+};
+
+template<typename P>
+struct discard_traits<builtin_try_skip<P>> {
+  static builtin_try_skip<P> discard( builtin_try_skip<P> p ) {
+    return p;
+  }
+};
+
+template<typename S>
+struct discard_traits<builtin_skip_many<S>> {
+  static builtin_skip_many<S> discard( builtin_skip_many<S> p ) {
+    return p;
+  }
+};
+
+// A discarded invoke (and so also a discarded emplace or seq)
+// does not call its function; its parsers are each discarded in
+// turn.
+template<typename Func, typename... Ps>
+struct discard_traits<builtin_invoke<Func, Ps...>> {
+  static auto discard( builtin_invoke<Func, Ps...> b ) {
+    using detail::discarded;
+    return std::apply(
+        []( Ps&... ps ) {
+          return builtin_invoke<
+              detail::ignore_all,
+              decltype( discarded( std::move( ps ) ) )...>{
+              {}, { discarded( std::move( ps ) )... } };
+        },
+        b.parsers );
+  }
+};
 
 } // namespace parsco
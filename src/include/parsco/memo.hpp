@@ -0,0 +1,270 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/ext.hpp"
+#include "parsco/magic.hpp"
+#include "parsco/parser.hpp"
+
+// C++ standard library
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/****************************************************************
+** Memoization (Packrat Parsing)
+*****************************************************************/
+// When a grammar has alternatives that share a prefix (or when a
+// failed alternative is followed by one that starts by parsing
+// the same thing) the same rule will end up being run multiple
+// times at the same position in the buffer. Wrapping a rule in
+// memo<Lang, T>() means that it is only ever run once at a given
+// position for the duration of a parse; the result (including
+// failure), the number of chars consumed, and the farthest posi-
+// tion reached are recorded and then replayed the next time
+// around. Memoizing all of the rules in a grammar gives a pack-
+// rat parser, which runs in linear time.
+//
+// This is strictly opt-in, since for most rules the bookkeeping
+// costs more than just running them again.
+namespace parsco {
+
+struct memo_stats {
+  long lookups = 0;
+  long hits    = 0;
+
+  // Fraction of lookups that found a result, or zero if there
+  // were no lookups.
+  double hit_rate() const {
+    return lookups == 0 ? 0.0 : double( hits ) / lookups;
+  }
+};
+
+// Holds the memoized results. Entries are keyed on the rule and
+// on the position in the buffer, so a table must not be reused
+// across parses of different buffers unless it is clear()'d in
+// between (or unless the buffer was edited and the table was
+// told about it, see below). An entry holds the result_t<T> of
+// the rule, and so T must be copyable.
+struct memo_table {
+  struct entry {
+    std::any result;
+    int      consumed = 0;
+    int      farthest = 0;
+    // Whether the rule read an absolute position (see position),
+    // in which case the result might hold offsets that are only
+    // right for where it was parsed.
+    bool positional = false;
+  };
+
+  memo_table() = default;
+
+  memo_table( memo_table const& ) = delete;
+  memo_table& operator=( memo_table const& ) = delete;
+
+  memo_stats const& stats() const { return stats_; }
+
+  std::size_t size() const { return entries_.size(); }
+
+  // Drops all entries, but keeps the stats.
+  void clear() {
+    entries_.clear();
+    spans_.clear();
+  }
+
+  // Returns nullptr if there is no entry. Pointers returned from
+  // here remain valid until the table is cleared, edited, or de-
+  // stroyed.
+  entry const* find( void const* rule, char const* pos );
+
+  // Returns the entry as it was stored; the same goes for the
+  // pointer as for the one from find.
+  entry const* insert( void const* rule, char const* pos,
+                       entry e );
+
+  /**************************************************************
+  ** Edits
+  ***************************************************************/
+  // By default entries are keyed on the address in the buffer.
+  // In order to keep the entries across edits the table must in-
+  // stead be told where the buffer is (before each parse, since
+  // the edits can move it), which must then be the case for all
+  // entries in it.
+  void set_buffer( std::string_view buffer );
+
+  // Adjusts the entries for an edit of the buffer, in which the
+  // `removed` chars at `offset` were replaced with `inserted`
+  // chars. Entries for rules that looked at any part of the ed-
+  // ited range (or at the char just after it, or reached the
+  // start of it) are dropped since their outcome might change.
+  // So are the positional entries after the edit when it changes
+  // the size of the buffer, since the offsets that they hold
+  // would then be off. Returns the number of entries that were
+  // dropped. This requires set_buffer to have been called.
+  //
+  // Entries before an edit are keyed on their distance from the
+  // start of the buffer and those after it on their distance
+  // from the end, so an edit does not change the keys of the
+  // ones that it doesn't drop, except for those in between it
+  // and the previous edit, which switch over. So this is cheap
+  // for edits that are close together, as is the case when typ-
+  // ing. There is still a scan over the table, but that does not
+  // touch the entries themselves.
+  std::size_t apply_edit( std::size_t offset,
+                          std::size_t removed,
+                          std::size_t inserted );
+
+private:
+  struct key {
+    void const* rule;
+    // For the entries before the split this is the offset from
+    // the start of the buffer, and for the ones after it this is
+    // negative: the offset from the end (minus one, so that it
+    // is never zero). In the default mode there is no buffer,
+    // and this is just the address.
+    std::intptr_t pos;
+
+    bool operator==( key const& ) const = default;
+  };
+
+  struct key_hash {
+    std::size_t operator()( key const& k ) const noexcept;
+  };
+
+  // Only maintained after set_buffer, for apply_edit.
+  struct span {
+    key  k;
+    int  extent;
+    bool positional;
+  };
+
+  key key_of( void const* rule, char const* pos ) const;
+
+  std::unordered_map<key, entry, key_hash> entries_;
+  memo_stats                               stats_;
+
+  std::vector<span> spans_;
+  bool              positional_ = false;
+  char const*       base_       = nullptr;
+  std::size_t       size_       = 0;
+  std::size_t       split_      = std::size_t( -1 );
+};
+
+// Returns the table that is currently installed on this thread,
+// or nullptr if there is none.
+memo_table* current_memo_table() noexcept;
+
+namespace detail {
+
+// Counts the reads of absolute positions on this thread, so that
+// a memoized rule can tell whether it did any; see entry::posi-
+// tional.
+inline constinit thread_local unsigned g_position_reads = 0;
+
+} // namespace detail
+
+// While this object is alive the given table will be used by all
+// memoized rules that run on this thread. Install one of these
+// around a call to run_parser in order to get at the stats.
+struct memo_scope {
+  explicit memo_scope( memo_table& table ) noexcept;
+  ~memo_scope() noexcept;
+
+  memo_scope( memo_scope const& ) = delete;
+  memo_scope& operator=( memo_scope const& ) = delete;
+
+private:
+  memo_table* prev_;
+};
+
+// Same as ensure_arena, but for memo tables. The parser runners
+// use this so that memoized results live for one parse.
+struct ensure_memo_table {
+  ensure_memo_table();
+
+private:
+  // Order matters; the scope must be torn down first.
+  std::optional<memo_table> own_;
+  std::optional<memo_scope> scope_;
+};
+
+/****************************************************************
+** builtin_memo
+*****************************************************************/
+// A magic awaitable that is recognized by the promise. `rule` is
+// the address of some object that uniquely identifies the rule
+// and `make` produces the parser<T> that is run on a miss. If no
+// memo table is installed then it just runs the parser.
+template<typename T, typename Func>
+struct builtin_memo {
+  using value_type = T;
+
+  static_assert( std::is_copy_constructible_v<T>,
+                 "memoized results must be copyable." );
+
+  operator parser<T>() const {
+    return detail::to_parser( *this );
+  }
+
+  void const* rule;
+  Func        make;
+};
+
+namespace detail {
+
+// Only the address of this is used, as the key of the rule.
+template<typename Lang, typename T>
+inline constexpr char memo_rule_key = 0;
+
+template<typename Lang, typename T>
+struct ParseRule {
+  parser<T> operator()() const { return parse<Lang, T>(); }
+};
+
+} // namespace detail
+
+// Memoized version of parse<Lang, T>().
+template<typename Lang, typename T>
+builtin_memo<T, detail::ParseRule<Lang, T>> memo() {
+  return { &detail::memo_rule_key<Lang, T>,
+           detail::ParseRule<Lang, T>{} };
+}
+
+// Same as above, but returns an owning parser object.
+template<typename Lang, typename T>
+parser<T> parse_memo() {
+  return memo<Lang, T>();
+}
+
+} // namespace parsco
@@ -0,0 +1,377 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/arena.hpp"
+#include "parsco/combinator.hpp"
+#include "parsco/error.hpp"
+#include "parsco/events.hpp"
+#include "parsco/magic.hpp"
+#include "parsco/memo.hpp"
+#include "parsco/parser.hpp"
+#include "parsco/profile.hpp"
+#include "parsco/promise.hpp"
+#include "parsco/recover.hpp"
+#include "parsco/runner.hpp"
+#include "parsco/stats.hpp"
+#include "parsco/trampoline.hpp"
+
+// C++ standard library
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/****************************************************************
+** Parallel Parsing
+*****************************************************************/
+// A parser has no state outside of its own promise (and those of
+// its children), and the per-parse state that the runners keep
+// (frame arena, memo table) is installed per thread. So parses
+// of independent inputs can run on different threads without any
+// synchronization, which is what this module does.
+namespace parsco {
+
+// A fixed set of worker threads that run index-based jobs. The
+// threads are started in the constructor and sleep in between
+// jobs, so a pool is meant to be created once and reused.
+struct thread_pool {
+  // The thread calling for_each_index also does work, so this
+  // creates `workers - 1` threads. Zero means one per hardware
+  // thread.
+  explicit thread_pool( unsigned workers = 0 );
+  ~thread_pool() noexcept;
+
+  thread_pool( thread_pool const& ) = delete;
+  thread_pool& operator=( thread_pool const& ) = delete;
+
+  // Total number of threads that work on a job, including the
+  // caller.
+  unsigned workers() const { return threads_.size() + 1; }
+
+  using job_fn = std::function<void( std::size_t )>;
+
+  // Calls fn( i ) for each i in [0, n), spread across the work-
+  // ers, and returns when all of them have finished. If any of
+  // the calls throw then the first exception is rethrown here
+  // (the remaining indices may or may not have been run).
+  //
+  // Only one job runs at a time; if the pool is already busy
+  // (e.g. if this is called from within one of its own jobs)
+  // then the indices are just run serially on the calling
+  // thread.
+  void for_each_index( std::size_t n, job_fn const& fn );
+
+private:
+  void thread_main();
+  // Takes the job's parameters as they were when the worker
+  // joined it, rather than reading the members without the lock.
+  void run_job( job_fn const& job, std::size_t size,
+                std::size_t grain );
+
+  std::vector<std::thread> threads_;
+
+  // Held for the duration of a job.
+  std::mutex submit_;
+
+  // The rest is guarded by m_, except for next_.
+  std::mutex               m_;
+  std::condition_variable  wake_;
+  std::condition_variable  done_;
+  job_fn const*            job_        = nullptr;
+  std::size_t              size_       = 0;
+  std::size_t              grain_      = 1;
+  std::atomic<std::size_t> next_       = 0;
+  unsigned long            generation_ = 0;
+  unsigned                 busy_       = 0;
+  bool                     stop_       = false;
+  std::exception_ptr       error_;
+};
+
+// A pool with one worker per hardware thread that is created on
+// first use and lives until the program exits. This is what is
+// used when no pool is given explicitly.
+thread_pool& default_thread_pool();
+
+namespace detail {
+
+// A frame arena that lives for as long as the calling thread, so
+// that successive parses on a pool thread reuse its memory.
+frame_arena& thread_arena();
+
+// What a region of parallel_many gets in place of the state that
+// is installed on the calling thread, since it might be parsed
+// on another one. It is set up the same way whichever thread
+// that turns out to be, and then merged back into the caller's.
+struct region_state {
+  std::optional<profile>     prof;
+  std::optional<trampoline>  tramp;
+  std::optional<diagnostics> diags;
+  std::optional<parse_stats> stats;
+  // The sink refers to the recorder.
+  std::optional<event_recorder> events;
+  std::optional<event_sink>     sink;
+  // Whether the region read an absolute position (see memo.hpp).
+  bool read_position = false;
+};
+
+// The state that is installed on the calling thread of
+// parallel_many, as it was when this was created.
+struct region_context {
+  region_context() noexcept;
+
+  // Adds what a region did to the state of the caller. This must
+  // be called on the calling thread, once for each region that
+  // counts, in order.
+  void merge( region_state const& state ) const;
+
+  profile*     prof;
+  trampoline*  tramp;
+  diagnostics* diags;
+  parse_stats* stats;
+  event_sink*  sink;
+};
+
+// Installs the state of a region for as long as it is alive, on
+// the thread that parses it. There is always a fresh memo table
+// since the caller's can't be shared across threads.
+struct region_scope {
+  region_scope( region_context const& ctx, region_state& state,
+                std::string_view in );
+  ~region_scope() noexcept;
+
+  region_scope( region_scope const& ) = delete;
+  region_scope& operator=( region_scope const& ) = delete;
+
+private:
+  region_state&                    state_;
+  unsigned                         reads_;
+  memo_table                       memo_;
+  memo_scope                       memo_scope_;
+  std::optional<profile_scope>     prof_;
+  std::optional<trampoline_scope>  tramp_;
+  std::optional<diagnostics_scope> diags_;
+  std::optional<stats_scope>       stats_;
+  std::optional<event_scope>       sink_;
+};
+
+} // namespace detail
+
+/****************************************************************
+** parse_batch
+*****************************************************************/
+// Parses each of the inputs as a T (in its entirety, as in
+// parse_from_string) and returns the results in input order.
+// The inputs are spread across the threads of the pool; each
+// thread allocates parser frames from its own arena, which is
+// reused from one input to the next. `filename` is used in error
+// messages, where positions are relative to the input in ques-
+// tion.
+template<typename Lang, typename T>
+std::vector<result_t<T>> parse_batch(
+    std::string_view                  filename,
+    std::span<std::string_view const> inputs,
+    thread_pool&                      pool ) {
+  std::vector<std::optional<result_t<T>>> slots( inputs.size() );
+  pool.for_each_index( inputs.size(), [&]( std::size_t i ) {
+    arena_scope scope( detail::thread_arena() );
+    slots[i].emplace(
+        parse_from_string<Lang, T>( filename, inputs[i] ) );
+  } );
+  std::vector<result_t<T>> res;
+  res.reserve( inputs.size() );
+  for( std::optional<result_t<T>>& slot : slots )
+    res.push_back( std::move( *slot ) );
+  return res;
+}
+
+// Same as above but with a temporary pool with one thread per
+// hardware thread. Prefer the above when parsing more than one
+// batch, since it avoids starting the threads each time.
+template<typename Lang, typename T>
+std::vector<result_t<T>> parse_batch(
+    std::string_view                  filename,
+    std::span<std::string_view const> inputs ) {
+  thread_pool pool;
+  return parse_batch<Lang, T>( filename, inputs, pool );
+}
+
+/****************************************************************
+** parallel_many
+*****************************************************************/
+// A scanner finds the end of the next top-level region at the
+// start of the given input (which is never empty) and returns
+// its length, including any delimiter. It should be fast and not
+// need to understand the grammar, e.g. it could just find the
+// next newline. Returning zero means "all of the rest".
+template<typename S>
+concept RegionScanner =
+    std::is_invocable_r_v<std::size_t, S const&,
+                          std::string_view>;
+
+// A scanner for regions that end with (and include) `delim`.
+inline auto delimited_by( char delim ) {
+  return [delim]( std::string_view in ) -> std::size_t {
+    void const* p = std::memchr( in.data(), delim, in.size() );
+    if( p == nullptr ) return in.size();
+    return static_cast<char const*>( p ) - in.data() + 1;
+  };
+}
+
+// See parallel_many below.
+template<typename T, typename Scanner, typename Func,
+         typename... Args>
+struct builtin_parallel_many {
+  using value_type = many_result_container_t<T>;
+
+  thread_pool*        pool;
+  Scanner             scan;
+  Func                f;
+  std::tuple<Args...> args;
+
+  BufferParseResult<value_type> run( std::string_view in,
+                                     int base = 0 ) const;
+
+  operator parser<value_type>() const {
+    return detail::to_parser( *this );
+  }
+};
+
+// Consumes all of the remaining input as a sequence of items in
+// parallel. The input is first split into regions with `scan`,
+// then on the threads of `pool` each region is parsed with
+// f( args... ) followed by blanks, which must consume all of it.
+// The results are returned in order, as with many. Regions that
+// contain only blanks are skipped.
+//
+// If any regions fail then the parse fails with the error from
+// the first one of them, at its position in the full input.
+//
+// The item parsers are created and run on the pool threads, so
+// `f`, `args` and anything that they refer to must be safe to
+// use from multiple threads at once.
+//
+// The state that the runners install on the calling thread is
+// not visible on the pool threads, so each region is given its
+// own, in the same way whichever thread it runs on: a profile,
+// a trampoline (at the caller's depth, with the same limit),
+// diagnostics for recover, parse_stats and an event sink (at the
+// caller's path, recording its events), each only if the caller
+// has one installed. These are merged back into the caller's,
+// for the regions up to and including the first one that
+// failed, in input order, as if they had been parsed in order.
+// The memo table does not carry across: each region gets a
+// fresh one, which is dropped when the region is done.
+template<RegionScanner Scanner, typename Func, typename... Args>
+auto parallel_many( thread_pool& pool, Scanner scan, Func f,
+                    Args... args ) {
+  using T = typename std::invoke_result_t<Func,
+                                          Args...>::value_type;
+  return builtin_parallel_many<T, Scanner, Func, Args...>{
+      &pool, std::move( scan ), std::move( f ),
+      { std::move( args )... } };
+}
+
+// Same as above, using the default_thread_pool().
+template<RegionScanner Scanner, typename Func, typename... Args>
+auto parallel_many( Scanner scan, Func f, Args... args ) {
+  return parallel_many( default_thread_pool(), std::move( scan ),
+                        std::move( f ), std::move( args )... );
+}
+
+template<typename T, typename Scanner, typename Func,
+         typename... Args>
+BufferParseResult<many_result_container_t<T>>
+builtin_parallel_many<T, Scanner, Func, Args...>::run(
+    std::string_view in, int base ) const {
+  struct region {
+    std::string_view     sv;
+    std::optional<T>     val      = {};
+    std::optional<error> err      = {};
+    int                  farthest = 0;
+  };
+
+  std::vector<region> regions;
+  for( std::string_view rest = in; !rest.empty(); ) {
+    std::size_t n = scan( rest );
+    if( n == 0 || n > rest.size() ) n = rest.size();
+    std::string_view const sv = rest.substr( 0, n );
+    rest.remove_prefix( n );
+    if( sv.find_first_not_of( " \t\r\n" ) != sv.npos )
+      regions.push_back( region{ .sv = sv } );
+  }
+
+  detail::region_context const      ctx;
+  std::vector<detail::region_state> states( regions.size() );
+  pool->for_each_index( regions.size(), [&]( std::size_t i ) {
+    region&              r = regions[i];
+    arena_scope          arena( detail::thread_arena() );
+    detail::region_scope scope( ctx, states[i], r.sv );
+    parser<T>            p = std::apply(
+        [&]( auto const&... as ) {
+          return exhaust( f( as... ) << blanks_sv() );
+        },
+        args );
+    p.resume( r.sv, base + int( r.sv.data() - in.data() ) );
+    if( p.is_error() ) {
+      r.err.emplace( std::move( p.error() ) );
+      r.farthest = p.farthest();
+    } else {
+      r.val.emplace( std::move( p.get() ) );
+    }
+  } );
+
+  BufferParseResult<value_type> res{ .res = value_type{} };
+  for( std::size_t i = 0; i < regions.size(); ++i ) {
+    region& r = regions[i];
+    ctx.merge( states[i] );
+    if( r.err.has_value() ) {
+      res.res      = std::move( *r.err );
+      res.farthest = int( r.sv.data() - in.data() ) + r.farthest;
+      return res;
+    }
+    res.res->push_back( std::move( *r.val ) );
+  }
+  res.consumed = int( in.size() );
+  res.farthest = int( in.size() );
+  return res;
+}
+
+} // namespace parsco
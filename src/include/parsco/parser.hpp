@@ -30,6 +30,7 @@
 // parsco
 #include "parsco/compat.hpp"
 #include "parsco/error.hpp"
+#include "parsco/trampoline.hpp"
 #include "parsco/unique-coro.hpp"
 
 // C++ standard library
@@ -58,9 +59,30 @@ struct [[nodiscard]] parser {
       h_( coro::coroutine_handle<promise_type<T>>::from_promise(
           *promise_ ) ) {}
 
-  void resume( std::string_view buffer ) {
-    promise_->in_ = buffer;
-    h_.h_.resume();
+  // `base` is the offset of the start of the buffer from the
+  // start of the whole input, which is what position() yields
+  // offsets relative to.
+  void resume( std::string_view buffer, int base = 0 ) {
+    promise_->in_   = buffer;
+    promise_->base_ = base;
+    trampoline* const t = detail::g_current_trampoline;
+    if( t != nullptr )
+      t->run( h_.h_ );
+    else
+      h_.h_.resume();
+  }
+
+  // Same as resume, but instead of running the parser this gets
+  // it ready to be run through the trampoline, returning the
+  // handle to run. When it succeeds it hands its parent back
+  // through `link` (see trampoline.hpp).
+  coro::coroutine_handle<> transfer(
+      std::string_view buffer, int base,
+      detail::transfer_link& link ) {
+    promise_->in_   = buffer;
+    promise_->base_ = base;
+    promise_->link_ = &link;
+    return h_.h_;
   }
 
   bool finished() const { return promise_->o_.has_value(); }
@@ -109,6 +131,11 @@ struct [[nodiscard]] parser {
     return promise_->o_->get_error();
   }
 
+  // Destroys the coroutine ahead of time; nothing but the des-
+  // tructor may be called after this. See on_child_failed in
+  // promise.hpp for why.
+  void destroy_early() noexcept { h_.reset(); }
+
   // This would be try anyway because of the unique_coro.
   parser( parser const& ) = delete;
   parser& operator=( parser const& ) = delete;
@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/concepts.hpp"
+#include "parsco/magic.hpp"
+#include "parsco/parser.hpp"
+
+// C++ standard library
+#include <chrono>
+#include <iosfwd>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+/****************************************************************
+** Profiling
+*****************************************************************/
+// When the library is built with PARSCO_PROFILE defined (the
+// ENABLE_PROFILING cmake option) then parsers can be given names
+// with `named`, and every time a named parser runs its stats are
+// recorded: how many times it ran, how many of those succeeded
+// and failed, the total time spent in it (including the time of
+// anything that it called), the number of chars that it con-
+// sumed, and the number of chars that it looked at before fail-
+// ing, which is the work that was thrown away due to backtrack-
+// ing. Each parse<Lang, T>() rule is named automatically after
+// T.
+//
+// When PARSCO_PROFILE is not defined, `named` just returns the
+// parser that it is given, so there is no cost whatsoever.
+namespace parsco {
+
+struct rule_stats {
+  long                     invocations = 0;
+  long                     successes   = 0;
+  long                     failures    = 0;
+  std::chrono::nanoseconds inclusive   = {};
+  long                     consumed    = 0;
+  long                     backtracked = 0;
+};
+
+// Collects the stats for all of the named rules that run while
+// it is installed. Names are not copied, so they must outlive
+// the profile; string literals are fine.
+struct profile {
+  profile() = default;
+
+  profile( profile const& ) = delete;
+  profile& operator=( profile const& ) = delete;
+
+  rule_stats& stats_for( std::string_view name ) {
+    return rules_[name];
+  }
+
+  std::unordered_map<std::string_view, rule_stats> const& rules()
+      const {
+    return rules_;
+  }
+
+  // Adds the stats of `part`, which was installed for a part of
+  // the parse that ran apart from the rest (see parallel_many).
+  void merge( profile const& part );
+
+  // Writes a table of all of the rules, most expensive first.
+  void report( std::ostream& out ) const;
+
+private:
+  std::unordered_map<std::string_view, rule_stats> rules_;
+};
+
+// Returns the profile that is currently installed on this
+// thread, or nullptr if there is none.
+profile* current_profile() noexcept;
+
+// While this object is alive the given profile collects the
+// stats of all of the named rules that run on this thread.
+struct profile_scope {
+  explicit profile_scope( profile& p ) noexcept;
+  ~profile_scope() noexcept;
+
+  profile_scope( profile_scope const& ) = delete;
+  profile_scope& operator=( profile_scope const& ) = delete;
+
+private:
+  profile* prev_;
+};
+
+// Used by the parser runners in profiling builds: if no profile
+// is installed, installs one for the lifetime of this object and
+// then writes its report to `out` when done.
+struct ensure_profile {
+  explicit ensure_profile( std::ostream& out );
+  ~ensure_profile();
+
+private:
+  std::ostream*                out_;
+  std::optional<profile>       own_;
+  std::optional<profile_scope> scope_;
+};
+
+#if defined( PARSCO_PROFILE )
+
+// A magic awaitable that runs `p` and records its stats under
+// `name` in the current profile (if any).
+template<Parser P>
+struct builtin_named {
+  using value_type = typename P::value_type;
+
+  // Only from an rvalue, since P might be move-only.
+  operator parser<value_type>() && {
+    return detail::to_parser( std::move( *this ) );
+  }
+
+  std::string_view name;
+  P                p;
+};
+
+template<Parser P>
+builtin_named<P> named( std::string_view name, P p ) {
+  return builtin_named<P>{ name, std::move( p ) };
+}
+
+#else
+
+template<Parser P>
+P named( std::string_view, P p ) {
+  return p;
+}
+
+#endif
+
+namespace detail {
+
+// Returns a readable name for the type T, for use as the name of
+// a rule.
+template<typename T>
+constexpr std::string_view type_name() {
+  std::string_view const fn = __PRETTY_FUNCTION__;
+  std::size_t const      start = fn.find( "T = " ) + 4;
+  std::size_t const      end   = fn.find_first_of( ";]", start );
+  return fn.substr( start, end - start );
+}
+
+} // namespace detail
+
+} // namespace parsco
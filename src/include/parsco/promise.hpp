@@ -28,22 +28,39 @@
 #pragma once
 
 // parsco
+#include "parsco/arena.hpp"
 #include "parsco/magic.hpp"
+#include "parsco/memo.hpp"
 #include "parsco/parser.hpp"
+#include "parsco/profile.hpp"
+#include "parsco/stats.hpp"
+#include "parsco/trampoline.hpp"
 
 // C++ standard library
+#include <algorithm>
+#include <any>
+#include <bit>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 /****************************************************************
 ** Macros
 *****************************************************************/
-#define BUILTIN_PARSER( name, err )                            \
-  auto await_transform( builtin_##name const& o ) noexcept {   \
-    return builtin_awaitable{ this, o.try_parse( in_ ), err }; \
+#define BUILTIN_PARSER( name, err )                          \
+  auto await_transform( builtin_##name const& o ) noexcept { \
+    auto       res    = o.try_parse( in_ );                  \
+    bool const at_end = !res.has_value() &&                  \
+                        o.failed_at_end( in_ );              \
+    return builtin_awaitable{ this, res, err, at_end };      \
   }
 
 /****************************************************************
@@ -53,6 +70,54 @@ namespace parsco {
 
 namespace detail {
 
+// Converts to a T by calling `make`. When one of these is passed
+// to co_return the promise constructs its result from it in
+// place, so the T that `make` returns is never moved.
+template<typename T, typename Make>
+struct deferred {
+  operator T() && { return make(); }
+
+  Make make;
+};
+
+// What a parser suspends on when it finishes. If it was started
+// through the trampoline then it has its parent run next.
+struct final_awaiter {
+  transfer_link* link;
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend( coro::coroutine_handle<> ) const noexcept {
+    if( link != nullptr ) g_current_trampoline->finish( *link );
+  }
+
+  void await_resume() const noexcept {}
+};
+
+// Wraps a builtin_invoke so that the promise hands its result
+// back as a deferred (see ToParser).
+template<typename Func, typename... Ps>
+struct in_place_invoke {
+  builtin_invoke<Func, Ps...> b;
+};
+
+template<typename T>
+inline constexpr bool is_parser_v = false;
+
+template<typename T>
+inline constexpr bool is_parser_v<parser<T>> = true;
+
+// Runs an invoke as a coroutine of its own, which co_awaits each
+// of its parsers in turn (see invoke_awaitable).
+template<typename Func, typename... Ps>
+parser<typename builtin_invoke<Func, Ps...>::value_type>
+invoke_frame( builtin_invoke<Func, Ps...> b );
+
+// Same for builtin_first (see first_awaitable).
+template<typename... Ps>
+parser<typename builtin_first<Ps...>::value_type> first_frame(
+    builtin_first<Ps...> b );
+
 // We put the return_value and return_void in these two structs
 // so that we can decide based on the type of T which one to in-
 // clude (we are only allowed to have one in a promise type).
@@ -74,6 +139,12 @@ struct promise_value_returner {
     static_cast<Derived&>( *this ).return_value_(
         std::move( val ) );
   }
+
+  template<typename Make>
+  void return_value( deferred<T, Make>&& val ) {
+    static_cast<Derived&>( *this ).emplace_value_(
+        std::move( val ) );
+  }
 };
 
 template<typename Derived>
@@ -95,9 +166,28 @@ struct promise_type
   std::string_view           in_       = "";
   int                        consumed_ = 0;
   int                        farthest_ = 0;
+  // Offset of the start of in_ (as it was given to this parser)
+  // from the start of the input.
+  int                        base_     = 0;
+  // Set if this parser was started through the trampoline.
+  detail::transfer_link*     link_     = nullptr;
+  // Nonzero while a builtin is running parsers in place (see
+  // ready_inline).
+  int                        inline_   = 0;
 
   promise_type() = default;
 
+  // Coroutine frames are allocated from the arena that is in-
+  // stalled on the current thread (the parser runners install
+  // one), falling back to the heap if there isn't one.
+  static void* operator new( std::size_t size ) {
+    return detail::allocate_frame( size );
+  }
+
+  static void operator delete( void* p, std::size_t size ) {
+    detail::deallocate_frame( p, size );
+  }
+
   std::string_view& buffer() { return in_; }
 
   // Always suspend initially because the coroutine is unable to
@@ -112,7 +202,7 @@ struct promise_type
     // Always suspend because the parser object owns the corou-
     // tine and will be the one to destroy it when it goes out of
     // scope.
-    return parsco::suspend_always{};
+    return detail::final_awaiter{ link_ };
   }
 
   // Ensure that this is not copyable. See
@@ -144,6 +234,12 @@ struct promise_type
     o_.emplace( val );
   }
 
+  template<typename Make>
+  void emplace_value_( detail::deferred<T, Make>&& val ) {
+    assert( !o_ );
+    o_.emplace( std::move( val ) );
+  }
+
   // Note this ends in an underscore; the real return_void, if
   // present, is provided by a base class so that we can control
   // when it appears.
@@ -157,10 +253,29 @@ struct promise_type
     return parsco::suspend_always{};
   }
 
+  // For the builtins that run their parsers right here. Those
+  // need the outcome of each one straight away, which means that
+  // it can't be run through the trampoline (see trampoline.hpp).
+  template<typename A>
+  bool ready_inline( A& a ) {
+    ++inline_;
+    bool const ok = a.await_ready();
+    --inline_;
+    return ok;
+  }
+
   template<typename U>
-  struct awaitable {
+  struct awaitable : detail::transfer_link {
     parser<U>     parser_;
     promise_type* promise_;
+    // Set if the parser was not run because it would have been
+    // nested too deeply (see trampoline.hpp).
+    bool too_deep_ = false;
+    // Set if the parser is being run through the trampoline.
+    bool transfer_ = false;
+    // Whether this parser (the parent) carries on when the one
+    // that it is awaiting fails.
+    bool may_fail_ = false;
 
     // Promise pointer so that template type can be inferred.
     awaitable( promise_type* p, parser<U> parser )
@@ -170,25 +285,88 @@ struct promise_type
       // At this point parser should be at its initial suspend
       // point, waiting to be run.
       assert( !parser_.finished() );
+      int const   pos = promise_->base_ + promise_->consumed_;
+      trampoline* t   = detail::g_current_trampoline;
+      if( t != nullptr ) {
+        if( !t->enter( pos ) ) {
+          too_deep_ = true;
+          return false;
+        }
+        if( promise_->inline_ == 0 ) {
+          transfer_ = true;
+          return false;
+        }
+      }
       // Now we need to give the parser's promise object the
       // buffer to be parsed.
-      parser_.resume( promise_->buffer() );
+      parser_.resume( promise_->buffer(), pos );
+      if( t != nullptr ) t->leave();
       // parser should be at its final suspend point now, waiting
       // to be destroyed by the parser object that owns it.
       assert( parser_.finished() );
+      merge_farthest();
+      return parser_.is_good();
+    }
+
+    void merge_farthest() {
       promise_->farthest_ =
           std::max( promise_->farthest_,
                     promise_->consumed_ + parser_.farthest() );
-      return parser_.is_good();
     }
 
-    void await_suspend( coro::coroutine_handle<> ) noexcept {
+    bool failed() const {
+      return too_deep_ || parser_.is_error();
+    }
+
+    error failure() const {
+      if( too_deep_ )
+        return error( static_text( "nesting too deep" ) );
+      return parser_.error();
+    }
+
+    void await_suspend( coro::coroutine_handle<> h ) noexcept {
+      if( transfer_ ) {
+        parent       = h;
+        child_failed = &on_child_failed;
+        detail::g_current_trampoline->start(
+            *this, parser_.transfer(
+                       promise_->buffer(),
+                       promise_->base_ + promise_->consumed_,
+                       *this ) );
+        return;
+      }
       // A parse failed.
-      promise_->o_.emplace( std::move( parser_.error() ) );
+      if( too_deep_ )
+        promise_->o_.emplace( failure() );
+      else
+        promise_->o_.emplace( std::move( parser_.error() ) );
     }
 
-    U await_resume() {
+    // The trampoline calls this when a parser that was run
+    // through it fails.
+    static coro::coroutine_handle<> on_child_failed(
+        detail::transfer_link& link ) {
+      auto& self = static_cast<awaitable&>( link );
+      self.merge_farthest();
+      if( self.may_fail_ ) return self.parent;
+      self.promise_->o_.emplace(
+          std::move( self.parser_.error() ) );
+      // The parent has failed too and so will never resume,
+      // which means that it won't get to destroy the child. That
+      // would otherwise happen when the outermost parser is de-
+      // stroyed, recursively through every level of nesting,
+      // which defeats the point of the trampoline. Since the
+      // trampoline calls this innermost first, the child's own
+      // children are already gone, so this doesn't recurse.
+      self.parser_.destroy_early();
+      return nullptr;
+    }
+
+    // The part of await_resume that consumes the chars, which is
+    // all that is needed when the result is being discarded.
+    void skip() {
       assert( parser_.is_good() );
+      if( transfer_ ) merge_farthest();
       int chars_consumed =
           promise_->buffer().size() - parser_.buffer().size();
       assert( chars_consumed >= 0 );
@@ -197,6 +375,10 @@ struct promise_type
       // We only consume chars upon success.
       promise_->buffer().remove_prefix( chars_consumed );
       promise_->consumed_ += chars_consumed;
+    }
+
+    U await_resume() {
+      skip();
       return std::move( parser_.get() );
     }
   };
@@ -207,9 +389,8 @@ struct promise_type
   }
 
   // This parser is allowed to fail.
-  template<typename P>
-  auto await_transform( try_<P> t ) noexcept {
-    using U = typename P::value_type;
+  template<typename U>
+  auto await_transform( try_<parser<U>> t ) noexcept {
     // Slight modification to awaitable to allow it to fail.
     struct tryable_awaitable : awaitable<U> {
       using Base = awaitable<U>;
@@ -218,68 +399,1015 @@ struct promise_type
       using Base::promise_;
 
       bool await_ready() noexcept {
+        Base::may_fail_ = true;
         Base::await_ready();
-        // This is a parser that is allowed to fail, so always
-        // return true;
-        return true;
+        // This is a parser that is allowed to fail, so it only
+        // suspends in order to run it through the trampoline.
+        return !Base::transfer_;
       }
 
       result_t<U> await_resume() {
-        if( parser_.is_error() ) return parser_.error();
+        if( Base::failed() ) {
+          detail::count_backtrack();
+          return Base::failure();
+        }
         return Base::await_resume();
       }
     };
     return tryable_awaitable( this, std::move( t.p ) );
   }
 
-  auto await_transform( builtin_next_char ) noexcept {
-    struct awaitable {
-      promise_type* p_;
+  // Handles all of the single-character builtins. These are
+  // run directly on the buffer without creating a coroutine.
+  template<typename B>
+  struct char_awaitable {
+    promise_type* p_;
+    B             b_;
 
-      bool await_ready() noexcept {
-        return ( p_->buffer().size() > 0 );
+    bool await_ready() noexcept {
+      std::string_view& buf = p_->buffer();
+      if( buf.empty() ) return false;
+      if( b_.accepts( buf[0] ) ) return true;
+      // A rejected char counts as having been looked at.
+      p_->farthest_ =
+          std::max( p_->farthest_, p_->consumed_ + 1 );
+      return false;
+    }
+
+    error failure() const {
+      std::string_view buf = p_->buffer();
+      if( buf.empty() ) return error::eof();
+      return b_.mismatch( buf[0] );
+    }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    char await_resume() noexcept {
+      std::string_view& buf = p_->buffer();
+      assert( !buf.empty() );
+      char res = buf[0];
+      buf.remove_prefix( 1 );
+      p_->consumed_++;
+      p_->farthest_ = std::max( p_->farthest_, p_->consumed_ );
+      return res;
+    }
+  };
+
+  template<CharBuiltin B>
+  auto await_transform( B b ) noexcept {
+    return char_awaitable<B>{ this, std::move( b ) };
+  }
+
+  // Handles all of the span builtins. These always succeed.
+  template<typename B>
+  struct span_awaitable {
+    promise_type* p_;
+    B             b_;
+    std::size_t   len_ = 0;
+
+    bool await_ready() noexcept {
+      std::string_view buf = p_->buffer();
+      while( len_ < buf.size() && b_.accepts( buf[len_] ) )
+        ++len_;
+      // The char that ended the run (if any) has been looked at,
+      // just as if it had been rejected by a single-character
+      // builtin.
+      if( len_ < buf.size() )
+        p_->farthest_ = std::max(
+            p_->farthest_, p_->consumed_ + int( len_ ) + 1 );
+      return true;
+    }
+
+    error failure() const { return error{}; }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::string_view await_resume() noexcept {
+      std::string_view& buf = p_->buffer();
+      std::string_view  res = buf.substr( 0, len_ );
+      buf.remove_prefix( len_ );
+      p_->consumed_ += int( len_ );
+      p_->farthest_ = std::max( p_->farthest_, p_->consumed_ );
+      return res;
+    }
+  };
+
+  template<SpanBuiltin B>
+  auto await_transform( B b ) noexcept {
+    return span_awaitable<B>{ this, std::move( b ) };
+  }
+
+  // Handles builtin_str. This compares the whole string against
+  // the buffer at once, but reports errors and the farthest po-
+  // sition exactly as if each char had been parsed with chr.
+  struct str_awaitable {
+    promise_type*    p_;
+    std::string_view s_;
+    // Length of the prefix of s_ that matches the buffer.
+    int matched_ = 0;
+
+    bool await_ready() noexcept {
+      std::string_view buf = p_->buffer();
+      if( buf.starts_with( s_ ) ) {
+        matched_ = int( s_.size() );
+        return true;
+      }
+      int const n = int( std::min( buf.size(), s_.size() ) );
+      while( matched_ < n && buf[matched_] == s_[matched_] )
+        ++matched_;
+      if( matched_ == int( s_.size() ) ) return true;
+      // As with chr, a rejected char counts as having been
+      // looked at, but hitting EOF does not.
+      int const seen = ( matched_ < int( buf.size() ) )
+                           ? matched_ + 1
+                           : matched_;
+      p_->farthest_ =
+          std::max( p_->farthest_, p_->consumed_ + seen );
+      return false;
+    }
+
+    error failure() const {
+      if( matched_ == int( p_->buffer().size() ) )
+        return error::eof();
+      return error::expected_char( s_[matched_] );
+    }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::monostate await_resume() noexcept {
+      std::string_view& buf = p_->buffer();
+      buf.remove_prefix( s_.size() );
+      p_->consumed_ += int( s_.size() );
+      p_->farthest_ = std::max( p_->farthest_, p_->consumed_ );
+      return {};
+    }
+  };
+
+  auto await_transform( builtin_str b ) noexcept {
+    return str_awaitable{ this, b.s };
+  }
+
+  // Handles builtin_lit. The length is a constant, so the com-
+  // parison on success compiles down to a few word compares.
+  template<fixed_string S>
+  struct lit_awaitable : str_awaitable {
+    bool await_ready() noexcept {
+      std::string_view const buf = this->p_->buffer();
+      if( buf.size() >= S.size() &&
+          std::memcmp( buf.data(), S.chars, S.size() ) == 0 ) {
+        this->matched_ = int( S.size() );
+        return true;
       }
+      // Let the general version figure out the error.
+      return str_awaitable::await_ready();
+    }
+  };
+
+  template<fixed_string S>
+  auto await_transform( builtin_lit<S> ) noexcept {
+    return lit_awaitable<S>{ { this, S.view() } };
+  }
+
+  // Handles builtin_keyword. Errors and the farthest position
+  // are reported as if each of the keywords that start with the
+  // right char had been tried with str.
+  template<typename K>
+  struct keyword_awaitable {
+    promise_type*    p_;
+    std::string_view match_ = {};
+    bool             eof_   = false;
 
-      void await_suspend( coro::coroutine_handle<> ) noexcept {
-        p_->o_.emplace( error( "EOF" ) );
+    bool await_ready() noexcept {
+      std::string_view const buf = p_->buffer();
+      if( buf.empty() ) {
+        eof_ = true;
+        return false;
+      }
+      std::uint64_t mask = K::kFirst[std::uint8_t( buf[0] )];
+      // The first char was rejected if nothing can match.
+      int seen = 1;
+      while( mask != 0 ) {
+        std::string_view const k =
+            K::kByLength[std::countr_zero( mask )];
+        mask &= mask - 1;
+        if( buf.starts_with( k ) ) {
+          match_ = k;
+          return true;
+        }
+        int const n = int( std::min( buf.size(), k.size() ) );
+        int       m = 1;
+        while( m < n && buf[m] == k[m] ) ++m;
+        if( m == int( buf.size() ) ) {
+          eof_ = true;
+          seen = std::max( seen, m );
+        } else {
+          seen = std::max( seen, m + 1 );
+        }
       }
+      p_->farthest_ =
+          std::max( p_->farthest_, p_->consumed_ + seen );
+      return false;
+    }
+
+    error failure() const {
+      if( eof_ ) return error::eof();
+      return error::expected( K::kExpected.data() );
+    }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::string_view await_resume() noexcept {
+      std::string_view& buf = p_->buffer();
+      buf.remove_prefix( match_.size() );
+      p_->consumed_ += int( match_.size() );
+      p_->farthest_ = std::max( p_->farthest_, p_->consumed_ );
+      return match_;
+    }
+  };
+
+  template<fixed_string... Ks>
+  auto await_transform( builtin_keyword<Ks...> ) noexcept {
+    return keyword_awaitable<builtin_keyword<Ks...>>{ this };
+  }
+
+  // Handles builtin_memo. On a hit the recorded outcome of the
+  // rule is replayed without running anything; on a miss the
+  // parser is run as usual and its outcome is recorded.
+  template<typename U>
+  struct memo_awaitable {
+    promise_type*               p_;
+    memo_table*                 table_;
+    void const*                 rule_;
+    memo_table::entry const*    hit_ = nullptr;
+    std::optional<awaitable<U>> miss_ = {};
+    // On a miss, the entry that the outcome was moved into (if
+    // it was recorded), which is where it is then taken from.
+    memo_table::entry const*    stored_ = nullptr;
 
-      char await_resume() noexcept {
-        assert( int( p_->buffer().size() ) >= 1 );
-        char res = p_->buffer()[0];
-        p_->buffer().remove_prefix( 1 );
-        p_->consumed_++;
-        p_->farthest_ = p_->consumed_;
-        return res;
+    static result_t<U> const& recorded(
+        memo_table::entry const* e ) {
+      return *std::any_cast<result_t<U>>( &e->result );
+    }
+
+    // Not noexcept since recording the outcome allocates.
+    bool await_ready() {
+      if( hit_ != nullptr ) {
+        p_->farthest_ = std::max(
+            p_->farthest_, p_->consumed_ + hit_->farthest );
+        // So that an enclosing memoized rule inherits it.
+        if( hit_->positional ) ++detail::g_position_reads;
+        return recorded( hit_ ).has_value();
       }
-    };
-    return awaitable{ this };
+      char const*    pos   = p_->buffer().data();
+      unsigned const reads = detail::g_position_reads;
+      bool const     ok    = p_->ready_inline( *miss_ );
+      if( table_ != nullptr && !miss_->too_deep_ ) {
+        parser<U>& child    = miss_->parser_;
+        int        consumed = 0;
+        if( ok )
+          consumed = p_->buffer().size() - child.buffer().size();
+        bool const positional =
+            ( detail::g_position_reads != reads );
+        stored_ = table_->insert(
+            rule_, pos,
+            memo_table::entry{
+                .result     = std::move( child.result() ),
+                .consumed   = consumed,
+                .farthest   = child.farthest(),
+                .positional = positional } );
+      }
+      return ok;
+    }
+
+    error failure() const {
+      if( hit_ != nullptr ) return recorded( hit_ ).get_error();
+      if( stored_ != nullptr )
+        return recorded( stored_ ).get_error();
+      return miss_->failure();
+    }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    U await_resume() {
+      if( stored_ != nullptr ) {
+        miss_->skip();
+        return *recorded( stored_ );
+      }
+      if( hit_ == nullptr ) return miss_->await_resume();
+      p_->buffer().remove_prefix( hit_->consumed );
+      p_->consumed_ += hit_->consumed;
+      return *recorded( hit_ );
+    }
+  };
+
+  template<typename U, typename Func>
+  auto await_transform( builtin_memo<U, Func> m ) {
+    memo_awaitable<U> res{ .p_     = this,
+                           .table_ = current_memo_table(),
+                           .rule_  = m.rule };
+    if( res.table_ != nullptr )
+      res.hit_ = res.table_->find( m.rule, in_.data() );
+    if( res.hit_ == nullptr )
+      res.miss_.emplace( this, m.make() );
+    return res;
   }
 
   struct builtin_awaitable {
     promise_type*                     p_;
     std::optional<BuiltinParseResult> res_;
-    std::string_view                  err_;
+    char const*                       err_;
+    // Failed only for lack of input.
+    bool at_end_ = false;
+
+    bool await_ready() noexcept {
+      if( res_.has_value() ) return true;
+      // Running out of input counts as having looked at all of
+      // it, so that parse_stream knows to retry with more.
+      if( at_end_ )
+        p_->farthest_ = std::max(
+            p_->farthest_,
+            p_->consumed_ + int( p_->buffer().size() ) );
+      return false;
+    }
+
+    error failure() const {
+      return error::expected( err_ );
+    }
 
-    constexpr bool await_ready() noexcept {
-      if( !res_ ) return false;
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::string_view await_resume() noexcept {
+      assert( res_.has_value() );
       std::string_view& buf      = p_->buffer();
       int               consumed = res_->consumed;
       assert( consumed >= 0 );
       buf.remove_prefix( consumed );
       p_->consumed_ += consumed;
-      p_->farthest_ = p_->consumed_;
+      p_->farthest_ = std::max( p_->farthest_, p_->consumed_ );
+      return res_->sv;
+    }
+  };
+
+  // Wraps one of the above magic awaitables so that it is al-
+  // lowed to fail, in which case nothing is consumed and the
+  // error is returned instead.
+  template<typename A>
+  struct tryable_builtin : A {
+    using result_type =
+        result_t<decltype( std::declval<A&>().await_resume() )>;
+
+    bool ok_ = false;
+
+    bool await_ready() noexcept {
+      ok_ = A::p_->ready_inline( static_cast<A&>( *this ) );
       return true;
     }
 
+    result_type await_resume() {
+      if( !ok_ ) {
+        detail::count_backtrack();
+        return A::failure();
+      }
+      return A::await_resume();
+    }
+  };
+
+  template<typename B>
+  auto await_transform( try_<B> t ) noexcept {
+    using A = decltype( await_transform( std::move( t.p ) ) );
+    return tryable_builtin<A>{
+        await_transform( std::move( t.p ) ) };
+  }
+
+  // Handles the numeric builtins.
+  template<typename B>
+  struct number_awaitable {
+    using value_type = typename B::value_type;
+
+    promise_type*                 p_;
+    NumberParseResult<value_type> res_;
+
+    bool await_ready() noexcept {
+      if( res_.err == nullptr ) return true;
+      // Point at the start of the number, unless at EOF (same as
+      // with the single-character builtins). A scan that ran in-
+      // to the end looked at all of it though, as with strings.
+      if( res_.at_end )
+        p_->farthest_ = std::max(
+            p_->farthest_,
+            p_->consumed_ + int( p_->buffer().size() ) );
+      else if( !p_->buffer().empty() )
+        p_->farthest_ =
+            std::max( p_->farthest_, p_->consumed_ + 1 );
+      return false;
+    }
+
+    error failure() const {
+      return error( static_text::assume_static( res_.err ) );
+    }
+
     void await_suspend( coro::coroutine_handle<> ) noexcept {
-      p_->o_.emplace(
-          error( "expected " + std::string( err_ ) ) );
+      p_->o_.emplace( failure() );
+    }
+
+    value_type await_resume() noexcept {
+      p_->buffer().remove_prefix( res_.consumed );
+      p_->consumed_ += res_.consumed;
+      // E.g. "1.5e" could still turn out to have an exponent.
+      int const seen =
+          res_.at_end ? int( p_->buffer().size() ) : 0;
+      p_->farthest_ =
+          std::max( p_->farthest_, p_->consumed_ + seen );
+      return res_.val;
+    }
+  };
+
+  template<typename U>
+  auto await_transform( builtin_int<U> b ) noexcept {
+    return number_awaitable<builtin_int<U>>{
+        this, b.try_parse( in_ ) };
+  }
+
+  template<typename U>
+  auto await_transform( builtin_float<U> b ) noexcept {
+    return number_awaitable<builtin_float<U>>{
+        this, b.try_parse( in_ ) };
+  }
+
+  // Handles builtin_invoke. The parsers are awaited one after
+  // the other right here, as if they had been awaited directly
+  // in this coroutine, except that if one of them fails then the
+  // chars consumed by the ones before it are put back.
+  template<typename Func, typename... Ps>
+  struct invoke_awaitable {
+    using value_type =
+        typename builtin_invoke<Func, Ps...>::value_type;
+
+    // Whether any of the parsers is a coroutine, which is what
+    // a trampoline would run.
+    static constexpr bool kHasFrames =
+        ( detail::is_parser_v<Ps> || ... );
+
+    promise_type*                p_;
+    builtin_invoke<Func, Ps...> b_;
+    std::tuple<std::optional<typename Ps::value_type>...> res_ =
+        {};
+    error err_ = {};
+    // When a trampoline is installed (and this is not being run
+    // in place by another builtin) the parsers are run by a
+    // coroutine of their own instead, so that the ones that are
+    // coroutines can be run through the trampoline.
+    std::optional<awaitable<value_type>> frame_ = {};
+
+    template<std::size_t I>
+    bool run_one() {
+      auto a = p_->await_transform(
+          std::move( std::get<I>( b_.parsers ) ) );
+      if( !p_->ready_inline( a ) ) {
+        err_ = a.failure();
+        return false;
+      }
+      std::get<I>( res_ ).emplace( a.await_resume() );
+      return true;
+    }
+
+    template<std::size_t... Idx>
+    bool run_all( std::index_sequence<Idx...> ) {
+      // Evaluated left to right, stopping at the first failure.
+      return ( run_one<Idx>() && ... );
+    }
+
+    bool await_ready() {
+      if constexpr( kHasFrames ) {
+        if( p_->inline_ == 0 &&
+            detail::g_current_trampoline != nullptr ) {
+          frame_.emplace(
+              p_, detail::invoke_frame( std::move( b_ ) ) );
+          return frame_->await_ready();
+        }
+      }
+      std::string_view const in       = p_->in_;
+      int const              consumed = p_->consumed_;
+      if( run_all( std::index_sequence_for<Ps...>{} ) )
+        return true;
+      p_->in_       = in;
+      p_->consumed_ = consumed;
+      return false;
+    }
+
+    error failure() const {
+      if constexpr( kHasFrames )
+        if( frame_.has_value() ) return frame_->failure();
+      return err_;
+    }
+
+    void await_suspend(
+        [[maybe_unused]] coro::coroutine_handle<> h ) noexcept {
+      if constexpr( kHasFrames )
+        if( frame_.has_value() )
+          return frame_->await_suspend( h );
+      p_->o_.emplace( failure() );
     }
 
-    std::string_view await_resume() noexcept { return res_->sv; }
+    value_type make() {
+      if constexpr( kHasFrames )
+        if( frame_.has_value() ) return frame_->await_resume();
+      return std::apply(
+          [this]( auto&... r ) -> value_type {
+            return std::apply(
+                std::move( b_.func ),
+                std::forward_as_tuple( std::move( *r )... ) );
+          },
+          res_ );
+    }
+
+    value_type await_resume() { return make(); }
   };
 
+  template<typename Func, typename... Ps>
+  auto await_transform( builtin_invoke<Func, Ps...> b ) {
+    return invoke_awaitable<Func, Ps...>{ .p_ = this,
+                                          .b_ = std::move( b ) };
+  }
+
+  // Handles builtin_first. The alternatives are run right here
+  // one after the other, as with invoke, until one of them suc-
+  // ceeds. One that fails has not consumed anything, but what it
+  // looked at counts towards the farthest position, so the error
+  // (which is the empty one, when none of them succeed) gets re-
+  // ported where the most promising alternative gave up.
+  template<typename... Ps>
+  struct first_awaitable {
+    using value_type = typename builtin_first<Ps...>::value_type;
+
+    // See invoke_awaitable.
+    static constexpr bool kHasFrames =
+        ( detail::is_parser_v<Ps> || ... );
+
+    promise_type*                        p_;
+    builtin_first<Ps...>                 b_;
+    std::optional<value_type>            res_   = {};
+    std::optional<awaitable<value_type>> frame_ = {};
+
+    template<std::size_t I>
+    bool try_one() {
+      auto a = p_->await_transform(
+          std::move( std::get<I>( b_.parsers ) ) );
+      if( !p_->ready_inline( a ) ) {
+        // Counts as a try_, which is what this used to be.
+        detail::count_backtrack();
+        return false;
+      }
+      res_.emplace( a.await_resume() );
+      return true;
+    }
+
+    template<std::size_t... Idx>
+    bool try_all( std::index_sequence<Idx...> ) {
+      // Evaluated left to right, stopping at the first success.
+      return ( try_one<Idx>() || ... );
+    }
+
+    bool await_ready() {
+      if constexpr( kHasFrames ) {
+        if( p_->inline_ == 0 &&
+            detail::g_current_trampoline != nullptr ) {
+          frame_.emplace(
+              p_, detail::first_frame( std::move( b_ ) ) );
+          return frame_->await_ready();
+        }
+      }
+      return try_all( std::index_sequence_for<Ps...>{} );
+    }
+
+    error failure() const {
+      if constexpr( kHasFrames )
+        if( frame_.has_value() ) return frame_->failure();
+      return error{};
+    }
+
+    void await_suspend(
+        [[maybe_unused]] coro::coroutine_handle<> h ) noexcept {
+      if constexpr( kHasFrames )
+        if( frame_.has_value() )
+          return frame_->await_suspend( h );
+      p_->o_.emplace( failure() );
+    }
+
+    value_type await_resume() {
+      if constexpr( kHasFrames )
+        if( frame_.has_value() ) return frame_->await_resume();
+      return std::move( *res_ );
+    }
+  };
+
+  template<typename... Ps>
+  auto await_transform( builtin_first<Ps...> b ) {
+    return first_awaitable<Ps...>{ .p_ = this,
+                                   .b_ = std::move( b ) };
+  }
+
+  // Same as invoke_awaitable, but the result is handed back in a
+  // form that lets it be constructed in place by co_return (see
+  // ToParser).
+  template<typename Func, typename... Ps>
+  struct in_place_invoke_awaitable
+    : invoke_awaitable<Func, Ps...> {
+    using Base = invoke_awaitable<Func, Ps...>;
+
+    auto await_resume() {
+      auto make = [this] { return Base::make(); };
+      return detail::deferred<typename Base::value_type,
+                              decltype( make )>{ make };
+    }
+  };
+
+  template<typename Func, typename... Ps>
+  auto await_transform(
+      detail::in_place_invoke<Func, Ps...> b ) {
+    return in_place_invoke_awaitable<Func, Ps...>{
+        { .p_ = this, .b_ = std::move( b.b ) } };
+  }
+
+  // Handles the buffer builtins.
+  template<typename B>
+  struct buffer_awaitable {
+    using value_type = typename B::value_type;
+
+    promise_type*                 p_;
+    BufferParseResult<value_type> res_;
+
+    bool await_ready() noexcept {
+      p_->farthest_ = std::max( p_->farthest_,
+                                p_->consumed_ + res_.farthest );
+      return res_.res.has_value();
+    }
+
+    error failure() const { return res_.res.get_error(); }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    value_type await_resume() {
+      p_->buffer().remove_prefix( res_.consumed );
+      p_->consumed_ += res_.consumed;
+      p_->farthest_ = std::max( p_->farthest_, p_->consumed_ );
+      return std::move( *res_.res );
+    }
+  };
+
+  template<BufferBuiltin B>
+  auto await_transform( B const& b ) {
+    if constexpr( requires { b.run( in_, base_ ); } ) {
+      ++detail::g_position_reads;
+      return buffer_awaitable<B>{
+          this, b.run( in_, base_ + consumed_ ) };
+    } else {
+      return buffer_awaitable<B>{ this, b.run( in_ ) };
+    }
+  }
+
+  // Runs p right here, the same way that invoke does, and then
+  // puts back whatever it consumed. Calls on_ok with its result
+  // if it succeeded, otherwise stores its error in `err`.
+  template<typename P, typename OnOk>
+  bool run_restoring( P&& p, error& err, OnOk&& on_ok ) {
+    std::string_view const in       = in_;
+    int const              consumed = consumed_;
+    auto       a  = await_transform( std::forward<P>( p ) );
+    bool const ok = ready_inline( a );
+    if( ok )
+      on_ok( a.await_resume() );
+    else
+      err = a.failure();
+    in_       = in;
+    consumed_ = consumed;
+    return ok;
+  }
+
+  // Handles builtin_peek_char.
+  struct peek_char_awaitable {
+    promise_type* p_;
+
+    bool await_ready() noexcept {
+      if( p_->in_.empty() ) return false;
+      p_->farthest_ =
+          std::max( p_->farthest_, p_->consumed_ + 1 );
+      return true;
+    }
+
+    error failure() const { return error::eof(); }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    char await_resume() const noexcept { return p_->in_[0]; }
+  };
+
+  auto await_transform( builtin_peek_char ) noexcept {
+    return peek_char_awaitable{ this };
+  }
+
+  // Handles builtin_eof. When there is more input, the next char
+  // counts as having been looked at, which is where the error is
+  // reported.
+  struct eof_awaitable {
+    promise_type* p_;
+
+    bool await_ready() noexcept {
+      if( p_->in_.empty() ) return true;
+      p_->farthest_ =
+          std::max( p_->farthest_, p_->consumed_ + 1 );
+      return false;
+    }
+
+    error failure() const {
+      return error( static_text(
+          "failed to parse all characters in input stream" ) );
+    }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::monostate await_resume() const noexcept { return {}; }
+  };
+
+  auto await_transform( builtin_eof ) noexcept {
+    return eof_awaitable{ this };
+  }
+
+  // Handles builtin_lookahead.
+  template<typename P>
+  struct lookahead_awaitable {
+    using value_type = typename P::value_type;
+
+    promise_type*             p_;
+    P                         parser_;
+    std::optional<value_type> res_ = {};
+    error                     err_ = {};
+
+    bool await_ready() {
+      return p_->run_restoring(
+          std::move( parser_ ), err_,
+          [&]( auto&& v ) { res_.emplace( std::move( v ) ); } );
+    }
+
+    error failure() const { return err_; }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    value_type await_resume() { return std::move( *res_ ); }
+  };
+
+  template<typename P>
+  auto await_transform( builtin_lookahead<P> b ) {
+    return lookahead_awaitable<P>{ .p_      = this,
+                                   .parser_ = std::move( b.p ) };
+  }
+
+  // Handles builtin_not_followed_by.
+  template<typename P>
+  struct not_followed_by_awaitable {
+    promise_type* p_;
+    P             parser_;
+
+    bool await_ready() {
+      error ignored;
+      return !p_->run_restoring( std::move( parser_ ), ignored,
+                                 []( auto&& ) {} );
+    }
+
+    error failure() const {
+      return error( static_text( "unexpected input" ) );
+    }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::monostate await_resume() const noexcept { return {}; }
+  };
+
+  template<typename P>
+  auto await_transform( builtin_not_followed_by<P> b ) {
+    return not_followed_by_awaitable<P>{
+        .p_ = this, .parser_ = std::move( b.p ) };
+  }
+
+  // Finishes a successful awaitable whose result is not wanted,
+  // without taking the result if the awaitable allows for it.
+  template<typename A>
+  static void skip_result( A& a ) {
+    if constexpr( requires { a.skip(); } )
+      a.skip();
+    else
+      (void)a.await_resume();
+  }
+
+  // Handles builtin_skip and (when Optional) builtin_try_skip.
+  template<typename P, bool Optional>
+  struct skip_awaitable {
+    promise_type* p_;
+    P             parser_;
+    error         err_ = {};
+
+    bool await_ready() {
+      auto a = p_->await_transform( std::move( parser_ ) );
+      if( p_->ready_inline( a ) ) {
+        skip_result( a );
+        return true;
+      }
+      err_ = a.failure();
+      if constexpr( Optional ) detail::count_backtrack();
+      return Optional;
+    }
+
+    error failure() const { return err_; }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {
+      p_->o_.emplace( failure() );
+    }
+
+    std::monostate await_resume() const noexcept { return {}; }
+  };
+
+  template<typename P>
+  auto await_transform( builtin_skip<P> b ) {
+    return skip_awaitable<P, false>{
+        .p_ = this, .parser_ = std::move( b.p ) };
+  }
+
+  template<typename P>
+  auto await_transform( builtin_try_skip<P> b ) {
+    return skip_awaitable<P, true>{
+        .p_ = this, .parser_ = std::move( b.p ) };
+  }
+
+  // Handles builtin_skip_many.
+  template<typename S>
+  struct skip_many_awaitable {
+    promise_type* p_;
+    S             s_;
+
+    bool await_ready() {
+      using parser_t = decltype( detail::fresh( s_ ) );
+      if constexpr( CharBuiltin<parser_t> ) {
+        // See many.
+        auto a = p_->await_transform(
+            span_for( detail::fresh( s_ ) ) );
+        if( p_->ready_inline( a ) ) skip_result( a );
+      } else {
+        while( true ) {
+          int const before = p_->consumed_;
+          auto a = p_->await_transform( detail::fresh( s_ ) );
+          if( !p_->ready_inline( a ) ) {
+            // As with the try_ in many.
+            detail::count_backtrack();
+            break;
+          }
+          skip_result( a );
+          // Otherwise it would succeed the same way forever.
+          if( p_->consumed_ == before ) break;
+        }
+      }
+      return true;
+    }
+
+    error failure() const { return error(); }
+
+    void await_suspend( coro::coroutine_handle<> ) noexcept {}
+
+    std::monostate await_resume() const noexcept { return {}; }
+  };
+
+  template<typename S>
+  auto await_transform( builtin_skip_many<S> const& b ) {
+    return skip_many_awaitable<S>{ .p_ = this, .s_ = b.s };
+  }
+
+  // Handles builtin_position.
+  struct position_awaitable {
+    int pos_;
+
+    constexpr bool await_ready() const noexcept { return true; }
+    error failure() const { return error(); }
+    void  await_suspend( coro::coroutine_handle<> ) noexcept {}
+    int   await_resume() const noexcept { return pos_; }
+  };
+
+  auto await_transform( builtin_position ) const noexcept {
+    ++detail::g_position_reads;
+    return position_awaitable{ base_ + consumed_ };
+  }
+
+  // Handles detail::get_cursor.
+  struct cursor_awaitable {
+    detail::cursor c_;
+
+    constexpr bool await_ready() const noexcept { return true; }
+    void await_suspend( coro::coroutine_handle<> ) noexcept {}
+    detail::cursor await_resume() const noexcept { return c_; }
+  };
+
+  auto await_transform( detail::get_cursor ) const noexcept {
+    return cursor_awaitable{
+        { .rest = in_, .farthest = farthest_ - consumed_ } };
+  }
+
+  // Handles detail::probe. Same as running the parser under a
+  // try_, except that nothing is consumed even on success.
+  template<typename U>
+  auto await_transform( detail::probe<U> pr ) noexcept {
+    struct probe_awaitable : awaitable<U> {
+      using Base = awaitable<U>;
+      using Base::Base;
+      using Base::parser_;
+
+      bool await_ready() noexcept {
+        Base::may_fail_ = true;
+        Base::await_ready();
+        return !Base::transfer_;
+      }
+
+      bool await_resume() const { return parser_.is_good(); }
+    };
+    return probe_awaitable( this, std::move( pr.p ) );
+  }
+
+#if defined( PARSCO_PROFILE )
+  // Wraps the awaitable of a named parser in order to record its
+  // stats in the current profile.
+  template<typename A>
+  struct profiled_awaitable {
+    using clock = std::chrono::steady_clock;
+
+    promise_type* p_;
+    rule_stats*   stats_;
+    A             a_;
+
+    bool await_ready() noexcept {
+      if( stats_ == nullptr ) return p_->ready_inline( a_ );
+      ++stats_->invocations;
+      // Measure how far this parser got on its own, then merge
+      // that back in.
+      int const  farthest = p_->farthest_;
+      auto const start    = clock::now();
+      p_->farthest_       = p_->consumed_;
+      bool const ok       = p_->ready_inline( a_ );
+      stats_->inclusive += clock::now() - start;
+      if( ok ) {
+        ++stats_->successes;
+      } else {
+        ++stats_->failures;
+        stats_->backtracked += p_->farthest_ - p_->consumed_;
+      }
+      p_->farthest_ = std::max( farthest, p_->farthest_ );
+      return ok;
+    }
+
+    error failure() const { return a_.failure(); }
+
+    void await_suspend( coro::coroutine_handle<> h ) noexcept {
+      a_.await_suspend( h );
+    }
+
+    auto await_resume() {
+      int const before = p_->consumed_;
+      auto      res    = a_.await_resume();
+      if( stats_ != nullptr )
+        stats_->consumed += p_->consumed_ - before;
+      return res;
+    }
+  };
+
+  template<typename P>
+  auto await_transform( builtin_named<P> n ) {
+    using A = decltype( await_transform( std::move( n.p ) ) );
+    profile* const prof = current_profile();
+    return profiled_awaitable<A>{
+        .p_     = this,
+        .stats_ = prof ? &prof->stats_for( n.name ) : nullptr,
+        .a_     = await_transform( std::move( n.p ) ) };
+  }
+#endif
+
   // These are the special builtin parsers that have special ac-
   // cess to the internals of the coroutine state (meaning, the
   // buffer). They are used for two reasons: to form the primi-
@@ -289,6 +1417,110 @@ struct promise_type
   BUILTIN_PARSER( identifier, "identifier" );
   BUILTIN_PARSER( single_quoted, "single-quoted string" );
   BUILTIN_PARSER( double_quoted, "double-quoted string" );
+  BUILTIN_PARSER( quoted, "quoted string" );
 };
 
+/****************************************************************
+** Owning parsers for magic awaitables
+*****************************************************************/
+namespace detail {
+
+struct ToParser {
+  // Take the awaitable by value for lifetime reasons.
+  template<typename B>
+  parser<typename B::value_type> operator()( B b ) const {
+    if constexpr( std::is_same_v<typename B::value_type,
+                                 std::monostate> )
+      co_await std::move( b );
+    else
+      co_return co_await std::move( b );
+  }
+
+  // This one constructs the result in place.
+  template<typename Func, typename... Ps>
+  parser<typename builtin_invoke<Func, Ps...>::value_type>
+  operator()( builtin_invoke<Func, Ps...> b ) const {
+    using res_t =
+        typename builtin_invoke<Func, Ps...>::value_type;
+    if constexpr( std::is_same_v<res_t, std::monostate> ) {
+      co_await std::move( b );
+    } else {
+      // Not a temporary; gcc destroys those twice here.
+      in_place_invoke<Func, Ps...> in_place{ std::move( b ) };
+      co_return co_await std::move( in_place );
+    }
+  }
+};
+
+inline constexpr ToParser to_parser_impl{};
+
+struct InvokeFrame {
+  template<typename Func, typename... Ps, std::size_t... Idx>
+  parser<typename builtin_invoke<Func, Ps...>::value_type>
+  operator()( builtin_invoke<Func, Ps...> b,
+              std::index_sequence<Idx...> ) const {
+    using res_t =
+        typename builtin_invoke<Func, Ps...>::value_type;
+    std::tuple<std::optional<typename Ps::value_type>...> res;
+    ( (void)std::get<Idx>( res ).emplace(
+          co_await std::move( std::get<Idx>( b.parsers ) ) ),
+      ... );
+    auto call = [&]( auto&... r ) -> res_t {
+      return std::apply(
+          std::move( b.func ),
+          std::forward_as_tuple( std::move( *r )... ) );
+    };
+    if constexpr( std::is_same_v<res_t, std::monostate> )
+      (void)std::apply( call, res );
+    else
+      co_return std::apply( call, res );
+  }
+};
+
+inline constexpr InvokeFrame invoke_frame_impl{};
+
+template<typename Func, typename... Ps>
+parser<typename builtin_invoke<Func, Ps...>::value_type>
+invoke_frame( builtin_invoke<Func, Ps...> b ) {
+  return invoke_frame_impl( std::move( b ),
+                            std::index_sequence_for<Ps...>{} );
+}
+
+struct FirstFrame {
+  template<typename... Ps, std::size_t... Idx>
+  parser<typename builtin_first<Ps...>::value_type>
+  operator()( builtin_first<Ps...> b,
+              std::index_sequence<Idx...> ) const {
+    using res_t = typename builtin_first<Ps...>::value_type;
+    std::optional<res_t> res;
+
+    auto one = [&]<typename Q>( Q& p ) -> parser<> {
+      if( res.has_value() ) co_return;
+      auto exp = co_await try_{ std::move( p ) };
+      if( exp.has_value() ) res.emplace( std::move( *exp ) );
+    };
+    ( co_await one( std::get<Idx>( b.parsers ) ), ... );
+
+    if( !res.has_value() ) co_await fail();
+    if constexpr( !std::is_same_v<res_t, std::monostate> )
+      co_return std::move( *res );
+  }
+};
+
+inline constexpr FirstFrame first_frame_impl{};
+
+template<typename... Ps>
+parser<typename builtin_first<Ps...>::value_type> first_frame(
+    builtin_first<Ps...> b ) {
+  return first_frame_impl( std::move( b ),
+                           std::index_sequence_for<Ps...>{} );
+}
+
+template<typename B>
+parser<typename B::value_type> to_parser( B b ) {
+  return to_parser_impl( std::move( b ) );
+}
+
+} // namespace detail
+
 } // namespace parsco
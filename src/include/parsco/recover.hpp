@@ -0,0 +1,183 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/combinator.hpp"
+#include "parsco/concepts.hpp"
+#include "parsco/error.hpp"
+#include "parsco/magic.hpp"
+#include "parsco/parser.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <concepts>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/****************************************************************
+** Error Recovery
+*****************************************************************/
+// Normally a parse stops at the first error. In order to report
+// as many errors as possible in one pass, a grammar can mark the
+// places where it is able to pick up again after an error with
+// recover( sync, p ): when p fails, the error is recorded and
+// the input is skipped up to the next place where `sync` matches
+// (e.g. the `,` or `]` after a bad element of a list), and then
+// the parse carries on as if p had produced nothing. The errors
+// are collected by run_parser_recovering (see runner.hpp); under
+// the other runners recover just runs p. The regions of
+// parallel_many collect theirs separately, on whichever thread
+// they run on, and then hand them to the caller in input order.
+namespace parsco {
+
+// An error that was recovered from. The offset is from the start
+// of the input.
+struct diagnostic {
+  int   offset = 0;
+  error err;
+};
+
+// Collects the diagnostics of one parse of `in`.
+struct diagnostics {
+  explicit diagnostics( std::string_view in ) : in_( in ) {}
+
+  diagnostics( diagnostics const& ) = delete;
+  diagnostics& operator=( diagnostics const& ) = delete;
+
+  std::string_view input() const { return in_; }
+
+  void add( int offset, error e ) {
+    all_.push_back(
+        { .offset = offset, .err = std::move( e ) } );
+  }
+
+  int size() const { return int( all_.size() ); }
+
+  // The diagnostics in input order. When a part of the input is
+  // parsed more than once (e.g. after backtracking) the same er-
+  // ror can get recorded more than once, so only the first one
+  // at each offset is kept.
+  std::vector<diagnostic> sorted() const;
+
+private:
+  std::string_view        in_;
+  std::vector<diagnostic> all_;
+};
+
+// Returns the diagnostics that are currently installed on this
+// thread, or nullptr if there are none.
+diagnostics* current_diagnostics() noexcept;
+
+// While this object is alive, recover will record its errors in
+// the given diagnostics when run on this thread.
+struct diagnostics_scope {
+  explicit diagnostics_scope( diagnostics& diags ) noexcept;
+  ~diagnostics_scope() noexcept;
+
+  diagnostics_scope( diagnostics_scope const& ) = delete;
+  diagnostics_scope& operator=( diagnostics_scope const& ) =
+      delete;
+
+private:
+  diagnostics* prev_;
+};
+
+/****************************************************************
+** recover
+*****************************************************************/
+namespace detail {
+
+// The sync parser is run at each position while skipping, so it
+// is given either as a copyable parser (e.g. a builtin like
+// one_of( ",]" )) or as a function that returns one; see fresh.
+template<typename S>
+auto make_sync( S const& s ) {
+  using parser_t = decltype( fresh( s ) );
+  return detail::probe<typename parser_t::value_type>{
+      fresh( s ) };
+}
+
+} // namespace detail
+
+// Runs p. If it fails, the error is recorded (at the position
+// that it would have been reported at) and the input is skipped
+// from there up to, but not including, the next position at
+// which `sync` would succeed, or to the end of the input. Yields
+// nullopt in that case. The exceptions are when p fails at the
+// end of the input, or right at a position where `sync` suc-
+// ceeds, since then there would be nothing to skip; this then
+// fails the same way (without recording the error), so that a
+// successful recover always makes progress and e.g. a
+// many( recover( ... ) ) ends there. An enclosing recover, if
+// any, then gets to deal with the error.
+//
+// A recorded error stays recorded even if an enclosing alterna-
+// tive (first, etc.) later fails and backtracks, so recover
+// should be used at the points where the grammar has committed,
+// such as the elements of a list.
+struct Recover {
+  template<typename Sync, Parser P>
+  auto operator()( Sync sync, P p ) const
+      -> parser<std::optional<typename P::value_type>> {
+    using res_t              = typename P::value_type;
+    diagnostics* const diags = current_diagnostics();
+    if( diags == nullptr ) {
+      res_t res = co_await std::move( p );
+      co_return std::move( res );
+    }
+    auto res = co_await try_{ std::move( p ) };
+    if( res.has_value() ) co_return std::move( *res );
+    detail::cursor const at = co_await detail::get_cursor{};
+    if( at.rest.empty() )
+      co_await fail( std::move( res.get_error() ) );
+    int const error_at      = std::max( at.farthest - 1, 0 );
+    if( error_at == 0 ) {
+      bool const synced = co_await detail::make_sync( sync );
+      if( synced ) co_await fail( std::move( res.get_error() ) );
+    }
+    diags->add(
+        int( at.rest.data() - diags->input().data() ) + error_at,
+        std::move( res.get_error() ) );
+    co_await detail::skip_chars{ error_at };
+    while( true ) {
+      bool const synced = co_await detail::make_sync( sync );
+      if( synced ) break;
+      auto c = co_await try_{ any_chr() };
+      if( !c.has_value() ) break;
+    }
+    co_return std::nullopt;
+  }
+};
+
+inline constexpr Recover recover{};
+
+} // namespace parsco
@@ -28,17 +28,28 @@
 #pragma once
 
 // parsco
+#include "parsco/arena.hpp"
 #include "parsco/combinator.hpp"
 #include "parsco/error.hpp"
+#include "parsco/events.hpp"
 #include "parsco/ext.hpp"
+#include "parsco/file.hpp"
+#include "parsco/memo.hpp"
 #include "parsco/parser.hpp"
 #include "parsco/promise.hpp"
+#include "parsco/recover.hpp"
+#include "parsco/stats.hpp"
+#include "parsco/trampoline.hpp"
 
 // C++ standard library
 #include <cassert>
-#include <sstream>
+#if defined( PARSCO_PROFILE )
+#  include <iostream>
+#endif
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 /****************************************************************
 ** Parser Runners
@@ -47,20 +58,145 @@ namespace parsco {
 
 // `filename` is the original file name that the string came
 // from, in order to improve error messages.
-template<typename T>
+//
+// All of the coroutine frames created while the parser runs are
+// allocated from a frame arena, which is freed all at once when
+// the parse finishes. If the caller has already installed an
+// arena (see arena.hpp) then that one will be used instead.
+//
+// The same goes for the table used by memoized rules (see
+// memo.hpp); install one beforehand in order to get its stats.
+//
+// `p` can be either a parser<T> or one of the magic awaitables
+// that converts to one.
+template<Parser P, typename T = typename P::value_type>
 result_t<T> run_parser( std::string_view filename,
-                        std::string_view in, parser<T> p ) {
-  p.resume( in );
-  assert( p.finished() );
-  if( p.is_error() ) {
+                        std::string_view in, P p ) {
+  ensure_arena      arena;
+  ensure_memo_table memo;
+#if defined( PARSCO_PROFILE )
+  // Reports go to stderr unless the caller has installed their
+  // own profile (see profile.hpp).
+  ensure_profile profile( std::cerr );
+#endif
+  // Take ownership of the parser here so that it gets destroyed
+  // before the arena. This is needed because when a parse fails,
+  // the suspended parsers in the chain still hold the frames of
+  // their children, which came from the arena.
+  parser<T> root = std::move( p );
+  root.resume( in );
+  assert( root.finished() );
+  if( root.is_error() ) {
     // It's always one too far, not sure why.
-    ErrorPos ep = ErrorPos::from_index( in, p.farthest() - 1 );
-    std::ostringstream oss;
-    oss << filename << ":error:" << ep.line << ":" << ep.col
-        << " " << p.error().what();
-    return result_t<T>( error( oss.str() ) );
+    line_index lines( in );
+    ErrorPos   ep = lines.pos_of( root.farthest() - 1 );
+    // This is the only place where the message gets formatted.
+    return result_t<T>(
+        error( format_error( filename, ep, root.error() ) ) );
   }
-  return std::move( p.result() );
+  return std::move( root.result() );
+}
+
+// Same as run_parser, but the parser runs on a trampoline (see
+// trampoline.hpp), so that nesting through co_await uses up heap
+// instead of stack. If `max_depth` is nonzero then no parser is
+// run at a depth beyond it, and if the parse fails because of
+// that then the error says so and points at where it happened.
+// That bounds the resources that a hostile input can consume.
+template<Parser P, typename T = typename P::value_type>
+result_t<T> run_parser_trampolined( std::string_view filename,
+                                    std::string_view in, P p,
+                                    int max_depth = 0 ) {
+  trampoline       t( max_depth );
+  trampoline_scope scope( t );
+
+  result_t<T> res = run_parser( filename, in, std::move( p ) );
+  if( res.has_value() || !t.exceeded() ) return res;
+  line_index lines( in );
+  return result_t<T>( error( format_error(
+      filename, lines.pos_of( t.exceeded_at() ),
+      error( "exceeded maximum nesting depth of " +
+             std::to_string( max_depth ) ) ) ) );
+}
+
+// Same as run_parser, but the events that the parser emits (see
+// events.hpp) are delivered to `handler` as the parse goes, ex-
+// cept for those in the subtrees that `filter` rules out, which
+// are skipped.
+template<Parser P, typename T = typename P::value_type>
+result_t<T> run_parser_events( std::string_view filename,
+                               std::string_view in, P p,
+                               event_handler& handler,
+                               path_filter    filter = {} ) {
+  event_sink  sink( handler, std::move( filter ) );
+  event_scope scope( sink );
+  return run_parser( filename, in, std::move( p ) );
+}
+
+// What run_parser_with_stats returns.
+template<typename T>
+struct stats_result {
+  result_t<T> result;
+  parse_stats stats;
+};
+
+// Same as run_parser, but also counts the frames, backtracks and
+// errors of the parse (see stats.hpp). The frame of `p` itself
+// was created before this was called and so is not counted; use
+// parse_from_string_with_stats to include it, or install a
+// stats_scope beforehand.
+template<Parser P, typename T = typename P::value_type>
+stats_result<T> run_parser_with_stats( std::string_view filename,
+                                       std::string_view in,
+                                       P                p ) {
+  parse_stats stats;
+  stats.input_bytes = long( in.size() );
+  stats_scope scope( stats );
+  result_t<T> res = run_parser( filename, in, std::move( p ) );
+  return { std::move( res ), stats };
+}
+
+// What run_parser_recovering returns.
+template<typename T>
+struct recovered_result {
+  // Set if the parser succeeded, which it can do even when there
+  // were errors that it recovered from.
+  std::optional<T> value;
+  // All of the errors, in input order, each formatted the same
+  // way as the one that run_parser reports.
+  std::vector<error> errors;
+
+  bool ok() const { return value.has_value() && errors.empty(); }
+};
+
+// Same as run_parser, but errors that the parser recovers from
+// (see recover.hpp) are collected instead of ending the parse,
+// so that all of them can be reported from one pass. If the
+// parser then fails anyway, its error comes last.
+template<Parser P, typename T = typename P::value_type>
+recovered_result<T> run_parser_recovering(
+    std::string_view filename, std::string_view in, P p ) {
+  ensure_arena      arena;
+  ensure_memo_table memo;
+#if defined( PARSCO_PROFILE )
+  ensure_profile profile( std::cerr );
+#endif
+  diagnostics       diags( in );
+  diagnostics_scope scope( diags );
+  // See run_parser.
+  parser<T> root = std::move( p );
+  root.resume( in );
+  assert( root.finished() );
+  recovered_result<T> res;
+  if( root.is_error() )
+    diags.add( root.farthest() - 1, root.error() );
+  else
+    res.value = std::move( *root.result() );
+  line_index lines( in );
+  for( diagnostic const& d : diags.sorted() )
+    res.errors.emplace_back( format_error(
+        filename, lines.pos_of( d.offset ), d.err ) );
+  return res;
 }
 
 // `filename` is the original file name that the string came
@@ -68,8 +204,60 @@ result_t<T> run_parser( std::string_view filename,
 template<typename Lang, typename T>
 result_t<T> parse_from_string( std::string_view filename,
                                std::string_view in ) {
+  // Install the arena here so that the top-level parser frames
+  // come from it as well.
+  ensure_arena arena;
   return run_parser( filename, in,
                      exhaust( parsco::parse<Lang, T>() ) );
 }
 
+// Same as parse_from_string, but also returns the counters for
+// the parse (see run_parser_with_stats).
+template<typename Lang, typename T>
+stats_result<T> parse_from_string_with_stats(
+    std::string_view filename, std::string_view in ) {
+  parse_stats stats;
+  stats.input_bytes = long( in.size() );
+  stats_scope scope( stats );
+  result_t<T> res = parse_from_string<Lang, T>( filename, in );
+  return { std::move( res ), stats };
+}
+
+// Same as parse_from_string, but for a grammar whose rules emit
+// events (see events.hpp), which go to `handler`. T is typically
+// just a tag, since the rules of such a grammar don't build any-
+// thing.
+template<typename Lang, typename T>
+result_t<T> parse_events( std::string_view filename,
+                          std::string_view in,
+                          event_handler&   handler,
+                          path_filter      filter = {} ) {
+  ensure_arena arena;
+  return run_parser_events( filename, in,
+                            exhaust( parsco::parse<Lang, T>() ),
+                            handler, std::move( filter ) );
+}
+
+// Parses the entire contents of the file at `path`, which is
+// memory-mapped where possible (see file.hpp) to avoid a copy.
+// The buffer holding the file contents is moved into `buffer` so
+// that the caller can keep it alive for as long as the result
+// refers to it (e.g. if it holds string_views).
+template<typename Lang, typename T>
+result_t<T> parse_from_file( std::string const& path,
+                             file_buffer&       buffer ) {
+  result_t<file_buffer> opened = file_buffer::open( path );
+  if( !opened ) return opened.get_error();
+  buffer = std::move( *opened );
+  return parse_from_string<Lang, T>( path, buffer.view() );
+}
+
+// Same as above, but the file is released before returning, so T
+// must not refer to the input.
+template<typename Lang, typename T>
+result_t<T> parse_from_file( std::string const& path ) {
+  file_buffer buffer;
+  return parse_from_file<Lang, T>( path, buffer );
+}
+
 } // namespace parsco
@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <cstddef>
+#include <iosfwd>
+
+/****************************************************************
+** Parse Stats
+*****************************************************************/
+// Counters for what a parse costs in terms of allocations and
+// failures, as opposed to time (see profile.hpp). They are cheap
+// enough to leave on in production: while a parse_stats is in-
+// stalled, each coroutine frame, backtrack and error costs an
+// increment or two, and when none is installed just a test of a
+// thread-local pointer. This is what gives the number of frames
+// per KB of input that a grammar needs, without running it under
+// a heap profiler.
+namespace parsco {
+
+struct parse_stats {
+  // Number of coroutine frames (i.e., parser invocations that
+  // were not run in place) created.
+  long frames = 0;
+  // Largest number of frames that were alive at the same time,
+  // which follows the depth of nesting in the input.
+  long peak_frames = 0;
+  // Total size of all of those frames.
+  long frame_bytes = 0;
+  // Number of times that a failure was caught by try_ (or by
+  // something that uses it, e.g. first, many or |) and the input
+  // was rewound.
+  long backtracks = 0;
+  // Number of error objects created to describe a failure, in-
+  // cluding the one that a runner formats when the parse fails.
+  // Empty errors, which are what a result_t holds when it has a
+  // value, and copies are not counted.
+  long errors = 0;
+  // Size of the input that the counters are for, if known, so
+  // that the report can give them per KB.
+  long input_bytes = 0;
+
+  // Number of the counted frames that are currently alive.
+  long live_frames = 0;
+
+  void on_frame_created( std::size_t size ) noexcept {
+    ++frames;
+    frame_bytes += long( size );
+    if( ++live_frames > peak_frames ) peak_frames = live_frames;
+  }
+
+  void on_frame_destroyed() noexcept { --live_frames; }
+
+  // Adds the counts of `part`, which was installed for a part of
+  // the parse that ran apart from the rest (see parallel_many),
+  // other than input_bytes. The peak assumes that the frames of
+  // the part were alive on top of those that are alive now.
+  void merge( parse_stats const& part ) noexcept {
+    frames += part.frames;
+    frame_bytes += part.frame_bytes;
+    backtracks += part.backtracks;
+    errors += part.errors;
+    if( live_frames + part.peak_frames > peak_frames )
+      peak_frames = live_frames + part.peak_frames;
+  }
+
+  // Writes the counters on one line, e.g.:
+  //
+  //   frames=120 (3.5/KB) peak=14 bytes=23040 (672.0/KB) ...
+  //
+  void report( std::ostream& out ) const;
+};
+
+// Returns the stats that are currently installed on this thread,
+// or nullptr if there are none.
+parse_stats* current_stats() noexcept;
+
+// While this object is alive, everything that parsers do on this
+// thread is counted in the given stats, which must outlive all
+// of the frames that get created. Scopes can be nested; the pre-
+// vious stats are restored (they do not see the counts of the
+// inner scope) when the scope ends.
+struct stats_scope {
+  explicit stats_scope( parse_stats& stats ) noexcept;
+  ~stats_scope() noexcept;
+
+  stats_scope( stats_scope const& ) = delete;
+  stats_scope& operator=( stats_scope const& ) = delete;
+
+private:
+  parse_stats* prev_;
+};
+
+namespace detail {
+
+// In the header so that the counting can be inlined into the
+// frame allocation functions and the promise (see arena.hpp).
+inline constinit thread_local parse_stats* g_current_stats =
+    nullptr;
+
+inline void count_backtrack() noexcept {
+  if( g_current_stats != nullptr ) ++g_current_stats->backtracks;
+}
+
+inline void count_error() noexcept {
+  if( g_current_stats != nullptr ) ++g_current_stats->errors;
+}
+
+} // namespace detail
+
+} // namespace parsco
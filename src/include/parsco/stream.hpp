@@ -0,0 +1,237 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/arena.hpp"
+#include "parsco/error.hpp"
+#include "parsco/ext.hpp"
+#include "parsco/memo.hpp"
+#include "parsco/parser.hpp"
+#include "parsco/promise.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/****************************************************************
+** Streaming Input
+*****************************************************************/
+// The parser runners in runner.hpp need the entire input in one
+// contiguous buffer. For inputs that are too large for that, but
+// that consist of a sequence of top-level items (e.g. log files
+// with one record per line, or a stream of json documents), the
+// runner in this module reads the input in chunks and parses one
+// item at a time out of a window over the input.
+//
+// Parsers run synchronously, so they can't suspend and wait for
+// more input in the middle of a token. Instead, if an item's
+// parser reached the end of the window (whether it succeeded or
+// failed) then it may have been cut short, so the runner reads
+// more input and parses that item again from its start. This
+// relies on the farthest position: the builtins that scan ahead,
+// such as quoted strings and numbers, count running into the
+// end of the buffer as having looked at all of it. A failure
+// that stopped short of the end is final and is reported right
+// away. Each retry at least doubles the window, so the total re-
+// parsing is linear in the size of the item.
+//
+// Once an item has been parsed it can no longer be backtracked
+// into, so the chars that it consumed are dropped from the win-
+// dow. Hence the window only ever needs to be about twice as
+// large as the largest item plus one chunk.
+namespace parsco {
+
+// Reads up to `n` chars into `dst` and returns the number of
+// chars read, which must only be zero at the end of the input,
+// or stream_read_error if the input could not be read.
+using stream_reader =
+    std::function<std::size_t( char* dst, std::size_t n )>;
+
+inline constexpr std::size_t stream_read_error =
+    std::size_t( -1 );
+
+stream_reader reader_for( std::istream& in );
+stream_reader reader_for( std::FILE* fp );
+// Uses ::read on a (POSIX) file descriptor.
+stream_reader fd_reader( int fd );
+
+// A window into the input. The chars in the window are always
+// contiguous, and the absolute position (line/col) of the start
+// of the window is tracked across all of the chars that have
+// been dropped.
+struct stream_window {
+  stream_window( stream_reader reader, std::size_t chunk_size );
+
+  std::string_view view() const;
+
+  // True when the reader has signaled the end of the input, in
+  // which case the window holds everything that remains. This is
+  // also set when the reader has failed.
+  bool eof() const { return eof_; }
+
+  // True when the reader has returned stream_read_error.
+  bool failed() const { return failed_; }
+
+  // Reads up to `n` chars (by default one chunk) onto the end of
+  // the window. Returns false if there was nothing more to read.
+  bool fill( std::size_t n = 0 );
+
+  // Same as fill, but reads at least as many chars as there are
+  // in the window already.
+  bool grow();
+
+  // Drops the first `n` chars of the window.
+  void consume( std::size_t n );
+
+  // Position of the start of the window in the input. The off-
+  // set is 64 bit since a stream may well be larger than 2 GiB.
+  int          line() const { return line_; }
+  int          col() const { return col_; }
+  std::int64_t offset() const { return offset_; }
+
+  // Position of the char at index `idx` within the window.
+  ErrorPos pos_of( int idx ) const;
+
+private:
+  stream_reader reader_;
+  std::size_t   chunk_size_;
+  std::string   buf_;
+  // Index in buf_ at which the window starts.
+  std::size_t start_ = 0;
+  bool         eof_    = false;
+  bool         failed_ = false;
+  int          line_   = 1;
+  int          col_    = 1;
+  std::int64_t offset_ = 0;
+};
+
+namespace detail {
+
+// Skips blanks before the next item, reading more input as need-
+// ed. Returns false if only blanks remained in the input.
+bool skip_stream_blanks( stream_window& w );
+
+std::string stream_error( std::string_view filename,
+                          stream_window const& w, int idx,
+                          error const& e );
+
+// The error for when the reader has failed, positioned at the
+// end of what was read.
+std::string stream_read_failure( std::string_view     filename,
+                                 stream_window const& w );
+
+} // namespace detail
+
+// Parses the input as a sequence of T's, optionally separated by
+// blanks, calling on_item with each one as soon as it has been
+// parsed. On success returns the number of items. Note that if T
+// (or anything in it) holds string_views into the buffer then
+// those are only valid until on_item returns. Each item must
+// consume some input; one that succeeds without doing so (e.g.
+// a many that matches nothing) fails the parse at that point.
+//
+// Memoized results (see memo.hpp) are kept for the duration of
+// one attempt at one item, since the window may move. Likewise
+// the offsets that position and spanned yield are relative to
+// the start of the item, since an offset into the whole stream
+// need not fit in an int; error messages still give the line and
+// column in the whole input.
+template<typename Lang, typename T, typename Func>
+result_t<std::size_t> parse_stream(
+    std::string_view filename, stream_reader reader,
+    Func on_item, std::size_t chunk_size = 64 * 1024 ) {
+  ensure_arena  arena;
+  memo_table    memo;
+  memo_scope    scope( memo );
+  stream_window w( std::move( reader ), chunk_size );
+  std::size_t   count = 0;
+  auto const read_failure = [&] {
+    return result_t<std::size_t>(
+        error( detail::stream_read_failure( filename, w ) ) );
+  };
+  while( detail::skip_stream_blanks( w ) ) {
+    while( true ) {
+      memo.clear();
+      std::string_view in   = w.view();
+      parser<T>        item = parse<Lang, T>();
+      item.resume( in );
+      assert( item.finished() );
+      // If the parser got as far as the end of the window then
+      // it might have gotten further given more input, and it
+      // might not have failed.
+      bool const cut_short = item.farthest() >= int( in.size() );
+      if( cut_short && w.grow() ) continue;
+      if( w.failed() ) return read_failure();
+      if( item.is_error() )
+        return result_t<std::size_t>(
+            error( detail::stream_error( filename, w,
+                                         item.farthest() - 1,
+                                         item.error() ) ) );
+      // Otherwise the same item would be parsed here forever.
+      if( item.consumed() == 0 )
+        return result_t<std::size_t>( error( detail::stream_error(
+            filename, w, std::max( item.farthest() - 1, 0 ),
+            error( static_text( "item consumed no input" ) ) ) ) );
+      on_item( std::move( item.get() ) );
+      ++count;
+      w.consume( item.consumed() );
+      break;
+    }
+  }
+  if( w.failed() ) return read_failure();
+  return count;
+}
+
+template<typename Lang, typename T, typename Func>
+result_t<std::size_t> parse_stream(
+    std::string_view filename, std::istream& in, Func on_item,
+    std::size_t chunk_size = 64 * 1024 ) {
+  return parse_stream<Lang, T>( filename, reader_for( in ),
+                                std::move( on_item ),
+                                chunk_size );
+}
+
+template<typename Lang, typename T, typename Func>
+result_t<std::size_t> parse_stream(
+    std::string_view filename, std::FILE* fp, Func on_item,
+    std::size_t chunk_size = 64 * 1024 ) {
+  return parse_stream<Lang, T>( filename, reader_for( fp ),
+                                std::move( on_item ),
+                                chunk_size );
+}
+
+} // namespace parsco
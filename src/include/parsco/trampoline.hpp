@@ -0,0 +1,201 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// parsco
+#include "parsco/compat.hpp"
+
+/****************************************************************
+** Trampoline
+*****************************************************************/
+// Normally a parser runs each parser that it awaits by resuming
+// it right there, and so every level of nesting in the grammar
+// is also a level (or several) of nesting on the machine stack.
+// A deeply nested input such as a JSON string starting with ten
+// thousand `[` can then overflow the stack.
+//
+// While a trampoline is installed (see trampoline_scope below),
+// a parser that co_awaits another parser instead suspends and
+// hands the child to the trampoline, which is a loop that re-
+// sumes whichever parser is to run next; when the child succeeds
+// it hands its parent back in the same way. When the child fails
+// it just suspends, and the trampoline hands the failure on to
+// the parent. This is symmetric transfer, except that it goes
+// through the loop instead of having await_suspend return the
+// next coroutine: compilers only turn the latter into a tail
+// call when optimizing, and so it would still use up stack in
+// debug and sanitizer builds. Either way, nesting through
+// co_await is only limited by the heap.
+//
+// A failure usually takes the parents down with it, and those
+// never resume to destroy their children. The trampoline goes
+// through them innermost first and destroys each failed child
+// as its parent fails, so that the chain is not torn down re-
+// cursively (one level of stack per level of nesting) when the
+// outermost parser is destroyed.
+//
+// Builtins that run their parsers in place (such as lookahead or
+// try_ around an invoke) still resume those directly, and so do
+// use stack; invoke itself, and so seq, >> and friends, runs its
+// parsers in a coroutine of its own when a trampoline is in-
+// stalled. To bound what is left, and to fail cleanly on input
+// that is too deep, the trampoline can be given a maximum depth.
+namespace parsco {
+
+namespace detail {
+
+// A parser that has been handed to the trampoline links itself
+// to its parent with one of these, which lives in the parent's
+// frame (in the awaitable) while the child runs.
+struct transfer_link {
+  transfer_link*           up     = nullptr;
+  coro::coroutine_handle<> parent = nullptr;
+  // Called by the trampoline when the child has failed. Returns
+  // the parent if it can carry on, otherwise nullptr, in which
+  // case the parent has failed as well.
+  coro::coroutine_handle<> ( *child_failed )( transfer_link& ) =
+      nullptr;
+};
+
+} // namespace detail
+
+struct trampoline {
+  // A max_depth of zero means no limit. The depth counts parsers
+  // (coroutines and builtins that run parsers in place), so one
+  // level of nesting in a grammar is typically a few of them.
+  explicit trampoline( int max_depth = 0 )
+    : max_depth_( max_depth ) {}
+
+  // Same as above, but starting out `depth` deep, e.g. for a
+  // part of the parse that runs apart from the rest but is nest-
+  // ed inside of it (see parallel_many).
+  trampoline( int max_depth, int depth )
+    : max_depth_( max_depth ),
+      depth_( depth ),
+      peak_depth_( depth ) {}
+
+  trampoline( trampoline const& ) = delete;
+  trampoline& operator=( trampoline const& ) = delete;
+
+  // Number of parsers currently nested inside one another.
+  int depth() const { return depth_; }
+
+  // The largest that depth() has been.
+  int peak_depth() const { return peak_depth_; }
+
+  int max_depth() const { return max_depth_; }
+
+  // Whether a parser has failed because it would have been
+  // nested more than max_depth deep, and if so, the offset in
+  // the input of the first one. This is sticky: a parser that
+  // fails like that can still be caught (e.g. by `first`), so
+  // the runner checks it to report the real cause of a failure.
+  bool exceeded() const { return exceeded_at_ >= 0; }
+  int  exceeded_at() const { return exceeded_at_; }
+
+  // Takes in the peak depth and the exceeded state of a tram-
+  // poline that was created as above for a part of the parse.
+  void merge( trampoline const& part ) {
+    if( part.peak_depth_ > peak_depth_ )
+      peak_depth_ = part.peak_depth_;
+    if( exceeded_at_ < 0 ) exceeded_at_ = part.exceeded_at_;
+  }
+
+  // Called before a parser starts running at offset `pos`. Re-
+  // turns false if it must not be run because of max_depth.
+  bool enter( int pos ) {
+    if( max_depth_ != 0 && depth_ >= max_depth_ ) {
+      if( exceeded_at_ < 0 ) exceeded_at_ = pos;
+      return false;
+    }
+    if( ++depth_ > peak_depth_ ) peak_depth_ = depth_;
+    return true;
+  }
+
+  void leave() { --depth_; }
+
+  // Called by a parent that has just suspended in order to run
+  // `child` through the trampoline.
+  void start( detail::transfer_link&   link,
+              coro::coroutine_handle<> child ) {
+    link.up = top_;
+    top_    = &link;
+    next_   = child;
+  }
+
+  // Called by a child that was started through the trampoline
+  // and has just succeeded.
+  void finish( detail::transfer_link& link ) {
+    top_ = link.up;
+    leave();
+    next_ = link.parent;
+  }
+
+  // Resumes h and keeps going until it either finishes or fails.
+  void run( coro::coroutine_handle<> h );
+
+private:
+  int                      max_depth_;
+  int                      depth_       = 0;
+  int                      peak_depth_  = 0;
+  int                      exceeded_at_ = -1;
+  detail::transfer_link*   top_         = nullptr;
+  coro::coroutine_handle<> next_        = nullptr;
+};
+
+// Returns the trampoline that is installed on this thread, or
+// nullptr if there is none.
+trampoline* current_trampoline() noexcept;
+
+// While this object is alive the given trampoline is used by all
+// parsers that run on this thread. Scopes can be nested; the
+// previous one is restored when the scope ends. Most users will
+// just call run_parser_trampolined instead (see runner.hpp).
+struct trampoline_scope {
+  explicit trampoline_scope( trampoline& t ) noexcept;
+  ~trampoline_scope() noexcept;
+
+  trampoline_scope( trampoline_scope const& ) = delete;
+  trampoline_scope& operator=( trampoline_scope const& ) =
+      delete;
+
+private:
+  trampoline* prev_;
+};
+
+namespace detail {
+
+// The trampoline that is installed on this thread, if any. As
+// with the current arena, this lives in the header so that the
+// check for it can be inlined into the parsers.
+inline constinit thread_local trampoline* g_current_trampoline =
+    nullptr;
+
+} // namespace detail
+
+} // namespace parsco
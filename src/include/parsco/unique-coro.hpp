@@ -45,6 +45,12 @@ struct unique_coro {
 
   ~unique_coro() noexcept { destroy(); }
 
+  // Destroys the coroutine now and leaves this empty.
+  void reset() noexcept {
+    destroy();
+    h_ = std::coroutine_handle<>{};
+  }
+
   unique_coro( unique_coro const& ) = delete;
   unique_coro& operator=( unique_coro const& ) = delete;
 
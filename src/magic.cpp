@@ -28,7 +28,22 @@
 #include "parsco/magic.hpp"
 
 // C++ standard library
+#include <array>
 #include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+
+#if defined( __SSE2__ )
+#  include <immintrin.h>
+#  define PARSCO_SIMD_X86 1
+#elif defined( __ARM_NEON )
+#  include <arm_neon.h>
+#  define PARSCO_SIMD_NEON 1
+#endif
 
 using namespace std;
 
@@ -36,19 +51,239 @@ namespace parsco {
 
 namespace {
 
+/****************************************************************
+** Character classes
+*****************************************************************/
 bool is_blank( char c ) {
   return ( c == ' ' ) || ( c == '\n' ) || ( c == '\r' ) ||
          ( c == '\t' );
 }
 
-bool is_leading_identifier_char( char c ) {
-  return ( c >= 'A' && c <= 'Z' ) || ( c >= 'a' && c <= 'z' ) ||
-         ( c == '_' );
+enum : uint8_t {
+  kIdentifier        = 1 << 0,
+  kLeadingIdentifier = 1 << 1,
+};
+
+constexpr array<uint8_t, 256> make_identifier_table() {
+  array<uint8_t, 256> res = {};
+  for( int c = 'a'; c <= 'z'; ++c )
+    res[c] = kIdentifier | kLeadingIdentifier;
+  for( int c = 'A'; c <= 'Z'; ++c )
+    res[c] = kIdentifier | kLeadingIdentifier;
+  for( int c = '0'; c <= '9'; ++c ) res[c] = kIdentifier;
+  res['_'] = kIdentifier | kLeadingIdentifier;
+  return res;
+}
+
+constexpr array<uint8_t, 256> kIdentifierTable =
+    make_identifier_table();
+
+bool has_class( char c, uint8_t cls ) {
+  return ( kIdentifierTable[uint8_t( c )] & cls ) != 0;
+}
+
+/****************************************************************
+** Blank scanning kernels
+*****************************************************************/
+// Each of these returns the index of the first char in [p, p+n)
+// that is not a blank, or n if they all are. Most runs of blanks
+// are short (a space or two between tokens) but those that are
+// not (indentation, pretty-printed json) are where the vector
+// versions pay off.
+size_t skip_blanks_scalar( char const* p, size_t n ) {
+  size_t i = 0;
+  while( i < n && is_blank( p[i] ) ) ++i;
+  return i;
+}
+
+#if defined( PARSCO_SIMD_X86 )
+size_t skip_blanks_sse2( char const* p, size_t n ) {
+  __m128i const space = _mm_set1_epi8( ' ' );
+  __m128i const lf    = _mm_set1_epi8( '\n' );
+  __m128i const cr    = _mm_set1_epi8( '\r' );
+  __m128i const tab   = _mm_set1_epi8( '\t' );
+  size_t        i     = 0;
+  for( ; i + 16 <= n; i += 16 ) {
+    __m128i const v = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>( p + i ) );
+    __m128i const blanks = _mm_or_si128(
+        _mm_or_si128( _mm_cmpeq_epi8( v, space ),
+                      _mm_cmpeq_epi8( v, lf ) ),
+        _mm_or_si128( _mm_cmpeq_epi8( v, cr ),
+                      _mm_cmpeq_epi8( v, tab ) ) );
+    unsigned const mask = ~_mm_movemask_epi8( blanks ) & 0xffff;
+    if( mask != 0 ) return i + __builtin_ctz( mask );
+  }
+  return i + skip_blanks_scalar( p + i, n - i );
+}
+
+#  if defined( __GNUC__ )
+__attribute__( ( target( "avx2" ) ) ) size_t skip_blanks_avx2(
+    char const* p, size_t n ) {
+  __m256i const space = _mm256_set1_epi8( ' ' );
+  __m256i const lf    = _mm256_set1_epi8( '\n' );
+  __m256i const cr    = _mm256_set1_epi8( '\r' );
+  __m256i const tab   = _mm256_set1_epi8( '\t' );
+  size_t        i     = 0;
+  for( ; i + 32 <= n; i += 32 ) {
+    __m256i const v = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>( p + i ) );
+    __m256i const blanks = _mm256_or_si256(
+        _mm256_or_si256( _mm256_cmpeq_epi8( v, space ),
+                         _mm256_cmpeq_epi8( v, lf ) ),
+        _mm256_or_si256( _mm256_cmpeq_epi8( v, cr ),
+                         _mm256_cmpeq_epi8( v, tab ) ) );
+    unsigned const mask = ~unsigned(
+        _mm256_movemask_epi8( blanks ) );
+    if( mask != 0 ) return i + __builtin_ctz( mask );
+  }
+  return i + skip_blanks_sse2( p + i, n - i );
+}
+#  endif
+#endif
+
+#if defined( PARSCO_SIMD_NEON )
+size_t skip_blanks_neon( char const* p, size_t n ) {
+  uint8x16_t const space = vdupq_n_u8( ' ' );
+  uint8x16_t const lf    = vdupq_n_u8( '\n' );
+  uint8x16_t const cr    = vdupq_n_u8( '\r' );
+  uint8x16_t const tab   = vdupq_n_u8( '\t' );
+  size_t           i     = 0;
+  for( ; i + 16 <= n; i += 16 ) {
+    uint8x16_t const v =
+        vld1q_u8( reinterpret_cast<uint8_t const*>( p + i ) );
+    uint8x16_t const blanks =
+        vorrq_u8( vorrq_u8( vceqq_u8( v, space ),
+                            vceqq_u8( v, lf ) ),
+                  vorrq_u8( vceqq_u8( v, cr ),
+                            vceqq_u8( v, tab ) ) );
+    // Narrow to four bits per byte so that the mask fits in 64
+    // bits; there is no movemask on NEON.
+    uint8x8_t const narrowed =
+        vshrn_n_u16( vreinterpretq_u16_u8( blanks ), 4 );
+    uint64_t const mask =
+        ~vget_lane_u64( vreinterpret_u64_u8( narrowed ), 0 );
+    if( mask != 0 ) return i + __builtin_ctzll( mask ) / 4;
+  }
+  return i + skip_blanks_scalar( p + i, n - i );
+}
+#endif
+
+using skip_blanks_fn = size_t ( * )( char const*, size_t );
+
+skip_blanks_fn select_skip_blanks() {
+#if defined( PARSCO_SIMD_X86 )
+#  if defined( __GNUC__ )
+  if( __builtin_cpu_supports( "avx2" ) ) return skip_blanks_avx2;
+#  endif
+  return skip_blanks_sse2;
+#elif defined( PARSCO_SIMD_NEON )
+  return skip_blanks_neon;
+#else
+  return skip_blanks_scalar;
+#endif
+}
+
+size_t skip_blanks( char const* p, size_t n ) {
+  static skip_blanks_fn const fn = select_skip_blanks();
+  return fn( p, n );
+}
+
+/****************************************************************
+** Quoted strings
+*****************************************************************/
+// Parses a string delimited by `quote`, which must begin the in-
+// put. The search for the closing quote is just a memchr, which
+// the standard library already vectorizes.
+optional<BuiltinParseResult> parse_quoted( string_view in,
+                                           char        quote ) {
+  if( in.empty() || in[0] != quote ) return nullopt;
+  void const* end =
+      memchr( in.data() + 1, quote, in.size() - 1 );
+  // EOF before closing quote?
+  if( end == nullptr ) return nullopt;
+  int const pos =
+      static_cast<char const*>( end ) - in.data() + 1;
+  assert( pos >= 2 );
+  string_view res( in.data() + 1, pos - 2 );
+  return BuiltinParseResult{ .sv = res, .consumed = pos };
+}
+
+/****************************************************************
+** Numbers
+*****************************************************************/
+bool is_digit( char c ) { return c >= '0' && c <= '9'; }
+
+// Returns 99 for chars that are not digits in any base.
+int digit_value( char c ) {
+  if( c >= '0' && c <= '9' ) return c - '0';
+  if( c >= 'a' && c <= 'z' ) return c - 'a' + 10;
+  if( c >= 'A' && c <= 'Z' ) return c - 'A' + 10;
+  return 99;
+}
+
+// Returns the number of leading decimal digits in `in`.
+size_t count_digits( string_view in ) {
+  size_t n = 0;
+  while( n < in.size() && is_digit( in[n] ) ) ++n;
+  return n;
+}
+
+size_t count_hex_digits( string_view in ) {
+  size_t n = 0;
+  while( n < in.size() && digit_value( in[n] ) < 16 ) ++n;
+  return n;
+}
+
+// True if `in` starts with a 0x/0X prefix that is followed by
+// `c` (so that e.g. the 0 in "0xyz" is still a number on its
+// own).
+bool has_hex_prefix( string_view in, auto follows ) {
+  return in.size() > 2 && in[0] == '0' &&
+         ( in[1] == 'x' || in[1] == 'X' ) &&
+         follows( in.substr( 2 ) );
+}
+
+// True if `in` is nothing but a 0x/0X prefix (plus the point, if
+// `point` is set), i.e. if it could not be told whether the pre-
+// fix is followed by digits before the input ran out.
+bool is_cut_hex_prefix( string_view in, bool point ) {
+  if( point && in.size() == 3 && in[2] == '.' )
+    in.remove_suffix( 1 );
+  return in.size() == 2 && in[0] == '0' &&
+         ( in[1] == 'x' || in[1] == 'X' );
+}
+
+char const kOutOfRange[] = "number out of range";
+
+// More input can never bring an integer that is out of range
+// back into range, so such a failure is final even when the scan
+// ran into the end, which keeps it reported at the start of the
+// number (see number_awaitable). Not so for floats, where an ex-
+// ponent that has yet to be read can scale the mantissa back.
+template<typename T>
+void final_if_out_of_range( NumberParseResult<T>& res ) {
+  if( res.err == kOutOfRange ) res.at_end = false;
 }
 
-bool is_identifier_char( char c ) {
-  return ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) ||
-         ( c >= 'a' && c <= 'z' ) || ( c == '_' );
+template<typename T>
+NumberParseResult<T> convert_number( string_view in,
+                                     size_t      start,
+                                     size_t end, auto... fmt ) {
+  NumberParseResult<T> res;
+  char const*          first = in.data() + start;
+  char const*          last  = in.data() + end;
+  auto [ptr, ec] = from_chars( first, last, res.val, fmt... );
+  if( ec == errc::result_out_of_range ) {
+    res.err = kOutOfRange;
+    return res;
+  }
+  if( ec != errc{} || ptr != last ) {
+    res.err = "expected number";
+    return res;
+  }
+  res.consumed = int( end );
+  return res;
 }
 
 } // namespace
@@ -56,8 +291,7 @@ bool is_identifier_char( char c ) {
 // Removes blanks.
 optional<BuiltinParseResult> builtin_blanks::try_parse(
     string_view in ) const {
-  int pos = 0;
-  while( pos < int( in.size() ) && is_blank( in[pos] ) ) ++pos;
+  int const pos = skip_blanks( in.data(), in.size() );
   auto res = BuiltinParseResult{ .sv       = in.substr( 0, pos ),
                                  .consumed = pos };
   return res;
@@ -65,11 +299,11 @@ optional<BuiltinParseResult> builtin_blanks::try_parse(
 
 optional<BuiltinParseResult> builtin_identifier::try_parse(
     string_view in ) const {
-  if( in.empty() || !is_leading_identifier_char( in[0] ) )
+  if( in.empty() || !has_class( in[0], kLeadingIdentifier ) )
     return nullopt;
-  int pos = 0;
+  int pos = 1;
   while( pos < int( in.size() ) &&
-         is_identifier_char( in[pos] ) )
+         has_class( in[pos], kIdentifier ) )
     ++pos;
   return BuiltinParseResult{ .sv       = in.substr( 0, pos ),
                              .consumed = pos };
@@ -77,30 +311,211 @@ optional<BuiltinParseResult> builtin_identifier::try_parse(
 
 optional<BuiltinParseResult> builtin_single_quoted::try_parse(
     string_view in ) const {
-  int pos = 0;
-  if( in.empty() || in[pos++] != '\'' ) return nullopt;
-  while( true ) {
-    // EOF before closing quote?
-    if( pos == int( in.size() ) ) return nullopt;
-    if( in[pos++] == '\'' ) break;
-  }
-  assert( pos >= 2 );
-  string_view res( in.data() + 1, pos - 2 );
-  return BuiltinParseResult{ .sv = res, .consumed = pos };
+  return parse_quoted( in, '\'' );
 };
 
 optional<BuiltinParseResult> builtin_double_quoted::try_parse(
     string_view in ) const {
-  int pos = 0;
-  if( in.empty() || in[pos++] != '"' ) return nullopt;
-  while( true ) {
-    // EOF before closing quote?
-    if( pos == int( in.size() ) ) return nullopt;
-    if( in[pos++] == '"' ) break;
-  }
-  assert( pos >= 2 );
-  string_view res( in.data() + 1, pos - 2 );
-  return BuiltinParseResult{ .sv = res, .consumed = pos };
+  return parse_quoted( in, '"' );
+};
+
+optional<BuiltinParseResult> builtin_quoted::try_parse(
+    string_view in ) const {
+  if( auto res = builtin_double_quoted{}.try_parse( in ); res )
+    return res;
+  return builtin_single_quoted{}.try_parse( in );
 };
 
+bool builtin_blanks::failed_at_end( string_view ) const {
+  return false;
+}
+
+bool builtin_identifier::failed_at_end( string_view in ) const {
+  return in.empty();
+}
+
+// A failure with the opening quote in place means that there
+// was no closing quote.
+bool builtin_single_quoted::failed_at_end(
+    string_view in ) const {
+  return in.empty() || in[0] == '\'';
+}
+
+bool builtin_double_quoted::failed_at_end(
+    string_view in ) const {
+  return in.empty() || in[0] == '"';
+}
+
+bool builtin_quoted::failed_at_end( string_view in ) const {
+  return in.empty() || in[0] == '"' || in[0] == '\'';
+}
+
+template<typename T>
+NumberParseResult<T> builtin_int<T>::try_parse(
+    string_view in ) const {
+  NumberParseResult<T> res;
+  size_t               pos      = 0;
+  bool                 negative = false;
+  if constexpr( is_signed_v<T> ) {
+    if( pos < in.size() && in[pos] == '-' ) {
+      negative = true;
+      ++pos;
+    }
+  }
+  if( base == 16 &&
+      has_hex_prefix( in.substr( pos ), []( string_view rest ) {
+        return count_hex_digits( rest ) > 0;
+      } ) )
+    pos += 2;
+  size_t end = pos;
+  while( end < in.size() && digit_value( in[end] ) < base )
+    ++end;
+  res.at_end = end == in.size() ||
+               ( base == 16 &&
+                 is_cut_hex_prefix( in.substr( pos ), false ) );
+  if( end == pos ) {
+    res.err = "expected integer";
+    return res;
+  }
+  // from_chars allows neither the prefix nor a sign on unsigned
+  // types, so convert the magnitude and then apply the sign.
+  using U = make_unsigned_t<T>;
+  NumberParseResult<U> mag =
+      convert_number<U>( in, pos, end, base );
+  if( mag.err != nullptr ) {
+    res.err = mag.err;
+    final_if_out_of_range( res );
+    return res;
+  }
+  U const max = U( numeric_limits<T>::max() );
+  if( mag.val > max + ( negative ? 1 : 0 ) ) {
+    res.err = kOutOfRange;
+    final_if_out_of_range( res );
+    return res;
+  }
+  res.val      = negative ? T( U( 0 ) - mag.val ) : T( mag.val );
+  res.consumed = int( end );
+  return res;
+}
+
+// Same as below, but for the hexadecimal form, starting just
+// after the 0x prefix. `start` is where the digits start.
+template<typename T>
+NumberParseResult<T> parse_hex_float( string_view in,
+                                      size_t start,
+                                      bool   negative ) {
+  size_t       pos        = start;
+  size_t const int_digits = count_hex_digits( in.substr( pos ) );
+  pos += int_digits;
+  bool   point       = false;
+  size_t frac_digits = 0;
+  if( pos < in.size() && in[pos] == '.' ) {
+    point = true;
+    ++pos;
+    frac_digits = count_hex_digits( in.substr( pos ) );
+    pos += frac_digits;
+  }
+  NumberParseResult<T> res;
+  // Where the scan stopped, so as to tell if it hit the end.
+  size_t looked = pos;
+  if( int_digits + frac_digits == 0 ) {
+    res.err    = "expected floating point number";
+    res.at_end = looked == in.size();
+    return res;
+  }
+  // The exponent is a power of two, written in decimal.
+  bool exponent = false;
+  if( pos < in.size() && ( in[pos] == 'p' || in[pos] == 'P' ) ) {
+    size_t exp = pos + 1;
+    if( exp < in.size() && ( in[exp] == '+' || in[exp] == '-' ) )
+      ++exp;
+    size_t const n = count_digits( in.substr( exp ) );
+    looked         = exp + n;
+    if( n > 0 ) {
+      exponent = true;
+      pos      = exp + n;
+    }
+  }
+  if( !point && !exponent ) {
+    res.err    = "expected floating point number";
+    res.at_end = looked == in.size();
+    return res;
+  }
+  // from_chars takes neither the prefix nor (after it) a sign.
+  res = convert_number<T>( in, start, pos, chars_format::hex );
+  if( res.err == nullptr && negative ) res.val = -res.val;
+  res.at_end = looked == in.size();
+  return res;
+}
+
+template<typename T>
+NumberParseResult<T> builtin_float<T>::try_parse(
+    string_view in ) const {
+  size_t pos = 0;
+  if( pos < in.size() && in[pos] == '-' ) ++pos;
+  if( has_hex_prefix( in.substr( pos ), []( string_view rest ) {
+        return count_hex_digits( rest ) > 0 ||
+               ( rest.size() > 1 && rest[0] == '.' &&
+                 count_hex_digits( rest.substr( 1 ) ) > 0 );
+      } ) )
+    return parse_hex_float<T>( in, pos + 2, pos > 0 );
+  // Otherwise a 0x prefix gets read as a plain 0 below.
+  bool const cut_prefix =
+      is_cut_hex_prefix( in.substr( pos ), true );
+  size_t const int_digits = count_digits( in.substr( pos ) );
+  pos += int_digits;
+  bool   point       = false;
+  size_t frac_digits = 0;
+  if( pos < in.size() && in[pos] == '.' ) {
+    point = true;
+    ++pos;
+    frac_digits = count_digits( in.substr( pos ) );
+    pos += frac_digits;
+  }
+  NumberParseResult<T> res;
+  // Where the scan stopped, so as to tell if it hit the end.
+  size_t looked = pos;
+  if( int_digits + frac_digits == 0 ) {
+    res.err    = "expected floating point number";
+    res.at_end = looked == in.size();
+    return res;
+  }
+  // The exponent is only included if it is well-formed; other-
+  // wise the `e` is left for the next parser.
+  bool exponent = false;
+  if( pos < in.size() && ( in[pos] == 'e' || in[pos] == 'E' ) ) {
+    size_t exp = pos + 1;
+    if( exp < in.size() && ( in[exp] == '+' || in[exp] == '-' ) )
+      ++exp;
+    size_t const n = count_digits( in.substr( exp ) );
+    looked         = exp + n;
+    if( n > 0 ) {
+      exponent = true;
+      pos      = exp + n;
+    }
+  }
+  if( !point && !exponent ) {
+    res.err    = "expected floating point number";
+    res.at_end = looked == in.size() || cut_prefix;
+    return res;
+  }
+  res = convert_number<T>( in, 0, pos, chars_format::general );
+  res.at_end = looked == in.size();
+  return res;
+}
+
+#define INSTANTIATE_NUMBER( builtin, T )                 \
+  template NumberParseResult<T> builtin<T>::try_parse( \
+      string_view ) const
+
+INSTANTIATE_NUMBER( builtin_int, int );
+INSTANTIATE_NUMBER( builtin_int, long );
+INSTANTIATE_NUMBER( builtin_int, long long );
+INSTANTIATE_NUMBER( builtin_int, unsigned int );
+INSTANTIATE_NUMBER( builtin_int, unsigned long );
+INSTANTIATE_NUMBER( builtin_int, unsigned long long );
+
+INSTANTIATE_NUMBER( builtin_float, float );
+INSTANTIATE_NUMBER( builtin_float, double );
+
 } // namespace parsco
@@ -0,0 +1,169 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/memo.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+namespace parsco {
+
+namespace {
+
+thread_local memo_table* g_current_memo_table = nullptr;
+
+} // namespace
+
+/****************************************************************
+** memo_table
+*****************************************************************/
+size_t memo_table::key_hash::operator()(
+    key const& k ) const noexcept {
+  size_t const h1 = hash<void const*>{}( k.rule );
+  size_t const h2 = hash<intptr_t>{}( k.pos );
+  return h1 ^ ( h2 + 0x9e3779b9 + ( h1 << 6 ) + ( h1 >> 2 ) );
+}
+
+memo_table::key memo_table::key_of( void const*  rule,
+                                    char const* pos ) const {
+  // In the default mode base_ is null, so this is the address.
+  size_t const off =
+      reinterpret_cast<uintptr_t>( pos ) -
+      reinterpret_cast<uintptr_t>( base_ );
+  if( off < split_ ) return key{ rule, intptr_t( off ) };
+  return key{ rule, intptr_t( off ) - intptr_t( size_ ) - 1 };
+}
+
+memo_table::entry const* memo_table::find( void const* rule,
+                                           char const* pos ) {
+  ++stats_.lookups;
+  auto it = entries_.find( key_of( rule, pos ) );
+  if( it == entries_.end() ) return nullptr;
+  ++stats_.hits;
+  return &it->second;
+}
+
+memo_table::entry const* memo_table::insert( void const* rule,
+                                             char const* pos,
+                                             entry       e ) {
+  key const  k          = key_of( rule, pos );
+  int const  extent     = max( e.consumed, e.farthest );
+  bool const positional = e.positional;
+  auto [it, added] =
+      entries_.insert_or_assign( k, std::move( e ) );
+  if( positional_ && added )
+    spans_.push_back( { k, extent, positional } );
+  return &it->second;
+}
+
+void memo_table::set_buffer( string_view buffer ) {
+  // Only the first time, since otherwise there might already be
+  // entries keyed on addresses.
+  if( !positional_ ) {
+    assert( entries_.empty() );
+    positional_ = true;
+  }
+  assert( buffer.size() == size_ || size_ == 0 );
+  base_ = buffer.data();
+  size_ = buffer.size();
+}
+
+size_t memo_table::apply_edit( size_t offset, size_t removed,
+                               size_t inserted ) {
+  assert( positional_ );
+  assert( offset + removed <= size_ );
+  size_t const edit_end = offset + removed;
+  size_t       dropped  = 0;
+  // Keys that need to switch between being relative to the start
+  // and relative to the end. Their nodes are pulled out of the
+  // map (without reallocating them) and put back once all of the
+  // keys are fixed, so that they can't collide with ones that
+  // have not been fixed yet.
+  vector<decltype( entries_ )::node_type> moved;
+  size_t                                  kept = 0;
+  for( span& sp : spans_ ) {
+    size_t const pos = ( sp.k.pos >= 0 )
+                           ? size_t( sp.k.pos )
+                           : size_ + 1 + size_t( sp.k.pos );
+    // The range that a rule depends on is taken to include the
+    // char just past what it looked at, since the builtins that
+    // stop at a char (e.g. blanks) don't count it as looked at.
+    bool const shifted = pos > edit_end && removed != inserted;
+    if( ( pos <= edit_end && pos + sp.extent >= offset ) ||
+        ( sp.positional && shifted ) ) {
+      entries_.erase( sp.k );
+      ++dropped;
+      continue;
+    }
+    // The distance from the start doesn't change for entries be-
+    // fore the edit, and the distance from the end doesn't
+    // change for those after it.
+    intptr_t const pos_key =
+        ( pos < offset )
+            ? intptr_t( pos )
+            : intptr_t( pos ) - intptr_t( size_ ) - 1;
+    if( pos_key != sp.k.pos ) {
+      moved.push_back( entries_.extract( sp.k ) );
+      sp.k.pos = moved.back().key().pos = pos_key;
+    }
+    spans_[kept++] = sp;
+  }
+  spans_.resize( kept );
+  for( auto& node : moved ) entries_.insert( std::move( node ) );
+  size_  = size_ - removed + inserted;
+  split_ = offset;
+  return dropped;
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+memo_table* current_memo_table() noexcept {
+  return g_current_memo_table;
+}
+
+memo_scope::memo_scope( memo_table& table ) noexcept
+  : prev_( g_current_memo_table ) {
+  g_current_memo_table = &table;
+}
+
+memo_scope::~memo_scope() noexcept {
+  g_current_memo_table = prev_;
+}
+
+ensure_memo_table::ensure_memo_table() {
+  if( g_current_memo_table != nullptr ) return;
+  own_.emplace();
+  scope_.emplace( *own_ );
+}
+
+} // namespace parsco
@@ -0,0 +1,250 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/parallel.hpp"
+
+// C++ standard library
+#include <algorithm>
+
+using namespace std;
+
+namespace parsco {
+
+namespace {
+
+// The pools whose jobs this thread is in the middle of running,
+// innermost first. A job that calls for_each_index on one of
+// them again must not try to lock its submit_ mutex, which this
+// thread may already hold.
+struct running_job {
+  thread_pool const* pool;
+  running_job const* outer;
+};
+
+thread_local running_job const* g_running_jobs = nullptr;
+
+bool is_running_job_of( thread_pool const* pool ) {
+  running_job const* j = g_running_jobs;
+  while( j != nullptr && j->pool != pool ) j = j->outer;
+  return j != nullptr;
+}
+
+// Marks this thread as running a job of the pool while alive.
+struct running_job_scope {
+  explicit running_job_scope( thread_pool const* pool )
+    : job_{ pool, g_running_jobs } {
+    g_running_jobs = &job_;
+  }
+  ~running_job_scope() { g_running_jobs = job_.outer; }
+
+  running_job_scope( running_job_scope const& ) = delete;
+  running_job_scope& operator=( running_job_scope const& ) =
+      delete;
+
+private:
+  running_job job_;
+};
+
+} // namespace
+
+/****************************************************************
+** thread_pool
+*****************************************************************/
+thread_pool::thread_pool( unsigned workers ) {
+  if( workers == 0 )
+    workers = max( thread::hardware_concurrency(), 1u );
+  threads_.reserve( workers - 1 );
+  for( unsigned i = 1; i < workers; ++i )
+    threads_.emplace_back( [this] { thread_main(); } );
+}
+
+thread_pool::~thread_pool() noexcept {
+  {
+    lock_guard lock( m_ );
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for( thread& t : threads_ ) t.join();
+}
+
+// Claims indices in blocks of `grain` until there are none left.
+void thread_pool::run_job( job_fn const& job, size_t size,
+                           size_t grain ) {
+  running_job_scope running( this );
+  while( true ) {
+    size_t const start = next_.fetch_add( grain );
+    if( start >= size ) return;
+    size_t const end = min( start + grain, size );
+    try {
+      for( size_t i = start; i < end; ++i ) job( i );
+    } catch( ... ) {
+      lock_guard lock( m_ );
+      if( !error_ ) error_ = current_exception();
+      // Make the other workers stop picking up work.
+      next_ = size;
+      return;
+    }
+  }
+}
+
+void thread_pool::thread_main() {
+  unsigned long seen = 0;
+  while( true ) {
+    job_fn const* job   = nullptr;
+    size_t        size  = 0;
+    size_t        grain = 1;
+    {
+      unique_lock lock( m_ );
+      wake_.wait( lock,
+                  [&] { return stop_ || generation_ != seen; } );
+      if( stop_ ) return;
+      seen = generation_;
+      // A worker that wakes up only after the job has finished
+      // must not touch next_, which the next job may have reset
+      // by the time this one would get to it.
+      if( job_ == nullptr ) continue;
+      job   = job_;
+      size  = size_;
+      grain = grain_;
+      ++busy_;
+    }
+    run_job( *job, size, grain );
+    {
+      lock_guard lock( m_ );
+      --busy_;
+    }
+    done_.notify_one();
+  }
+}
+
+void thread_pool::for_each_index( size_t       n,
+                                  job_fn const& fn ) {
+  auto const serial = [&] {
+    for( size_t i = 0; i < n; ++i ) fn( i );
+  };
+  // Checked first, since this thread might be holding submit_.
+  if( is_running_job_of( this ) || threads_.empty() || n <= 1 )
+    return serial();
+  unique_lock submit( submit_, try_to_lock );
+  if( !submit.owns_lock() ) return serial();
+  // Small enough blocks to balance out uneven inputs, but big
+  // enough that the workers are not all contending on next_.
+  size_t const grain = max<size_t>( 1, n / ( workers() * 8 ) );
+  {
+    lock_guard lock( m_ );
+    job_   = &fn;
+    size_  = n;
+    grain_ = grain;
+    next_  = 0;
+    error_ = nullptr;
+    ++generation_;
+  }
+  wake_.notify_all();
+  run_job( fn, n, grain );
+  exception_ptr error;
+  {
+    unique_lock lock( m_ );
+    // Wait for the other workers to run out of indices. A worker
+    // that has not woken up yet by the time they have run out
+    // skips this job when it does (see thread_main).
+    done_.wait( lock, [&] {
+      return busy_ == 0 && next_.load() >= size_;
+    } );
+    job_ = nullptr;
+    error = exchange( error_, nullptr );
+  }
+  if( error ) rethrow_exception( error );
+}
+
+thread_pool& default_thread_pool() {
+  static thread_pool pool;
+  return pool;
+}
+
+/****************************************************************
+** Thread arenas
+*****************************************************************/
+namespace detail {
+
+frame_arena& thread_arena() {
+  thread_local frame_arena arena;
+  return arena;
+}
+
+/****************************************************************
+** Regions
+*****************************************************************/
+region_context::region_context() noexcept
+  : prof( current_profile() ),
+    tramp( current_trampoline() ),
+    diags( current_diagnostics() ),
+    stats( current_stats() ),
+    sink( current_event_sink() ) {}
+
+void region_context::merge( region_state const& state ) const {
+  if( prof != nullptr ) prof->merge( *state.prof );
+  if( tramp != nullptr ) tramp->merge( *state.tramp );
+  if( diags != nullptr ) {
+    // The offsets are from the start of the region.
+    int const shift = int( state.diags->input().data() -
+                           diags->input().data() );
+    for( diagnostic& d : state.diags->sorted() )
+      diags->add( shift + d.offset, std::move( d.err ) );
+  }
+  if( stats != nullptr ) stats->merge( *state.stats );
+  if( sink != nullptr )
+    sink->merge( *state.sink, *state.events );
+  if( state.read_position ) ++g_position_reads;
+}
+
+region_scope::region_scope( region_context const& ctx,
+                            region_state&         state,
+                            string_view           in )
+  : state_( state ),
+    reads_( g_position_reads ),
+    memo_scope_( memo_ ) {
+  if( ctx.prof != nullptr )
+    prof_.emplace( state.prof.emplace() );
+  if( ctx.tramp != nullptr )
+    tramp_.emplace( state.tramp.emplace(
+        ctx.tramp->max_depth(), ctx.tramp->depth() ) );
+  if( ctx.diags != nullptr )
+    diags_.emplace( state.diags.emplace( in ) );
+  if( ctx.stats != nullptr )
+    stats_.emplace( state.stats.emplace() );
+  if( ctx.sink != nullptr )
+    sink_.emplace( state.sink.emplace(
+        *ctx.sink, state.events.emplace() ) );
+}
+
+region_scope::~region_scope() noexcept {
+  state_.read_position = ( g_position_reads != reads_ );
+}
+
+} // namespace detail
+
+} // namespace parsco
@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/profile.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace parsco {
+
+namespace {
+
+thread_local profile* g_current_profile = nullptr;
+
+} // namespace
+
+/****************************************************************
+** profile
+*****************************************************************/
+void profile::merge( profile const& part ) {
+  for( auto const& [name, st] : part.rules_ ) {
+    rule_stats& into = rules_[name];
+    into.invocations += st.invocations;
+    into.successes += st.successes;
+    into.failures += st.failures;
+    into.inclusive += st.inclusive;
+    into.consumed += st.consumed;
+    into.backtracked += st.backtracked;
+  }
+}
+
+void profile::report( ostream& out ) const {
+  vector<pair<string_view, rule_stats>> sorted( rules_.begin(),
+                                                rules_.end() );
+  sort( sorted.begin(), sorted.end(),
+        []( auto const& l, auto const& r ) {
+          return l.second.inclusive > r.second.inclusive;
+        } );
+  // Type names of rules can get very long, so cap the width.
+  size_t const kMaxWidth = 48;
+  size_t       width     = 4;
+  for( auto const& [name, _] : sorted )
+    width = min( max( width, name.size() ), kMaxWidth );
+  auto const truncated = [&]( string_view name ) {
+    if( name.size() <= width ) return string( name );
+    return string( name.substr( 0, width - 3 ) ) + "...";
+  };
+  auto const row = [&]( auto name, auto calls, auto ok,
+                        auto fail, auto ms, auto consumed,
+                        auto backtracked ) {
+    out << left << setw( width ) << name << right << setw( 10 )
+        << calls << setw( 10 ) << ok << setw( 10 ) << fail
+        << setw( 12 ) << ms << setw( 12 ) << consumed
+        << setw( 12 ) << backtracked << "\n";
+  };
+  row( "rule", "calls", "ok", "fail", "time(ms)", "consumed",
+       "backtracked" );
+  for( auto const& [name, st] : sorted ) {
+    double const ms =
+        chrono::duration<double, milli>( st.inclusive ).count();
+    ostringstream time;
+    time << fixed << setprecision( 3 ) << ms;
+    row( truncated( name ), st.invocations, st.successes,
+         st.failures, time.str(), st.consumed, st.backtracked );
+  }
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+profile* current_profile() noexcept { return g_current_profile; }
+
+profile_scope::profile_scope( profile& p ) noexcept
+  : prev_( g_current_profile ) {
+  g_current_profile = &p;
+}
+
+profile_scope::~profile_scope() noexcept {
+  g_current_profile = prev_;
+}
+
+ensure_profile::ensure_profile( ostream& out ) : out_( &out ) {
+  if( g_current_profile != nullptr ) return;
+  own_.emplace();
+  scope_.emplace( *own_ );
+}
+
+ensure_profile::~ensure_profile() {
+  scope_.reset();
+  // Don't clutter the output for parses with no named rules.
+  if( own_.has_value() && !own_->rules().empty() )
+    own_->report( *out_ );
+}
+
+} // namespace parsco
@@ -0,0 +1,79 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/recover.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace parsco {
+
+namespace {
+
+thread_local diagnostics* g_current_diagnostics = nullptr;
+
+} // namespace
+
+/****************************************************************
+** diagnostics
+*****************************************************************/
+vector<diagnostic> diagnostics::sorted() const {
+  vector<diagnostic> res = all_;
+  stable_sort( res.begin(), res.end(),
+               []( diagnostic const& l, diagnostic const& r ) {
+                 return l.offset < r.offset;
+               } );
+  auto last = unique(
+      res.begin(), res.end(),
+      []( diagnostic const& l, diagnostic const& r ) {
+        return l.offset == r.offset;
+      } );
+  res.erase( last, res.end() );
+  return res;
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+diagnostics* current_diagnostics() noexcept {
+  return g_current_diagnostics;
+}
+
+diagnostics_scope::diagnostics_scope(
+    diagnostics& diags ) noexcept
+  : prev_( g_current_diagnostics ) {
+  g_current_diagnostics = &diags;
+}
+
+diagnostics_scope::~diagnostics_scope() noexcept {
+  g_current_diagnostics = prev_;
+}
+
+} // namespace parsco
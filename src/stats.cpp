@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/stats.hpp"
+
+// C++ standard library
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+using namespace std;
+
+namespace parsco {
+
+using detail::g_current_stats;
+
+/****************************************************************
+** parse_stats
+*****************************************************************/
+void parse_stats::report( ostream& out ) const {
+  // Formatted separately so as not to change the flags of out.
+  ostringstream line;
+  line << fixed << setprecision( 1 );
+  auto const field = [&]( char const* name, long n,
+                          bool per_kb ) {
+    line << name << '=' << n;
+    if( per_kb && input_bytes > 0 )
+      line << " (" << double( n ) * 1024 / double( input_bytes )
+           << "/KB)";
+  };
+  field( "frames", frames, true );
+  field( " peak", peak_frames, false );
+  field( " bytes", frame_bytes, true );
+  field( " backtracks", backtracks, true );
+  field( " errors", errors, true );
+  out << line.str() << "\n";
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+parse_stats* current_stats() noexcept { return g_current_stats; }
+
+stats_scope::stats_scope( parse_stats& stats ) noexcept
+  : prev_( g_current_stats ) {
+  g_current_stats = &stats;
+}
+
+stats_scope::~stats_scope() noexcept { g_current_stats = prev_; }
+
+} // namespace parsco
@@ -0,0 +1,175 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/stream.hpp"
+
+// parsco
+#include "parsco/magic.hpp"
+
+// C++ standard library
+#include <algorithm>
+#include <cerrno>
+#include <istream>
+
+#if __has_include( <unistd.h> )
+#  include <unistd.h>
+#  define PARSCO_HAS_UNISTD 1
+#endif
+
+using namespace std;
+
+namespace parsco {
+
+/****************************************************************
+** Readers
+*****************************************************************/
+stream_reader reader_for( istream& in ) {
+  return [&in]( char* dst, size_t n ) -> size_t {
+    in.read( dst, n );
+    if( in.bad() ) return stream_read_error;
+    return in.gcount();
+  };
+}
+
+stream_reader reader_for( FILE* fp ) {
+  return [fp]( char* dst, size_t n ) -> size_t {
+    size_t const got = fread( dst, 1, n, fp );
+    if( got == 0 && ferror( fp ) ) return stream_read_error;
+    return got;
+  };
+}
+
+stream_reader fd_reader( int fd ) {
+#if defined( PARSCO_HAS_UNISTD )
+  return [fd]( char* dst, size_t n ) -> size_t {
+    while( true ) {
+      ssize_t const res = ::read( fd, dst, n );
+      if( res >= 0 ) return res;
+      // Interrupted by a signal before anything was read.
+      if( errno != EINTR ) return stream_read_error;
+    }
+  };
+#else
+  (void)fd;
+  // No file descriptors on this platform, so this just looks
+  // like an empty input.
+  return []( char*, size_t ) -> size_t { return 0; };
+#endif
+}
+
+/****************************************************************
+** stream_window
+*****************************************************************/
+stream_window::stream_window( stream_reader reader,
+                              size_t        chunk_size )
+  : reader_( std::move( reader ) ), chunk_size_( chunk_size ) {
+  assert( chunk_size_ > 0 );
+  fill();
+}
+
+string_view stream_window::view() const {
+  return string_view( buf_ ).substr( start_ );
+}
+
+bool stream_window::fill( size_t n ) {
+  if( eof_ ) return false;
+  if( n == 0 ) n = chunk_size_;
+  // Chars before the window can no longer be reached by any
+  // parser, so this is a good time to reclaim that space, but
+  // only if there is enough of it to be worth the move.
+  if( start_ > 0 && start_ >= buf_.size() / 2 ) {
+    buf_.erase( 0, start_ );
+    start_ = 0;
+  }
+  size_t const old_size = buf_.size();
+  buf_.resize( old_size + n );
+  size_t got = reader_( buf_.data() + old_size, n );
+  if( got == stream_read_error ) {
+    failed_ = true;
+    got     = 0;
+  }
+  buf_.resize( old_size + got );
+  if( got == 0 ) eof_ = true;
+  return got > 0;
+}
+
+bool stream_window::grow() {
+  return fill( max( chunk_size_, buf_.size() - start_ ) );
+}
+
+void stream_window::consume( size_t n ) {
+  assert( start_ + n <= buf_.size() );
+  for( char c : string_view( buf_ ).substr( start_, n ) ) {
+    ++col_;
+    if( c == '\n' ) {
+      ++line_;
+      col_ = 1;
+    }
+  }
+  start_ += n;
+  offset_ += int64_t( n );
+}
+
+ErrorPos stream_window::pos_of( int idx ) const {
+  ErrorPos const ep = ErrorPos::from_index( view(), idx );
+  if( ep.line > 1 )
+    return ErrorPos{ .line = line_ + ep.line - 1,
+                     .col  = ep.col };
+  return ErrorPos{ .line = line_, .col = col_ + ep.col - 1 };
+}
+
+/****************************************************************
+** Helpers
+*****************************************************************/
+namespace detail {
+
+bool skip_stream_blanks( stream_window& w ) {
+  while( true ) {
+    auto res = builtin_blanks{}.try_parse( w.view() );
+    assert( res.has_value() );
+    w.consume( res->consumed );
+    if( !w.view().empty() ) return true;
+    if( !w.fill() ) return false;
+  }
+}
+
+string stream_error( string_view filename,
+                     stream_window const& w, int idx,
+                     error const& e ) {
+  return format_error( filename, w.pos_of( idx ), e );
+}
+
+string stream_read_failure( string_view          filename,
+                            stream_window const& w ) {
+  return stream_error(
+      filename, w, int( w.view().size() ),
+      error( static_text( "failed to read input" ) ) );
+}
+
+} // namespace detail
+
+} // namespace parsco
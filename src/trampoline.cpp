@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 David P. Sicilia (dpacbach)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without re-
+ * striction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following con-
+ * ditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Soft-
+ * ware.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PUR-
+ * POSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHER-
+ * WISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "parsco/trampoline.hpp"
+
+namespace parsco {
+
+using detail::g_current_trampoline;
+
+/****************************************************************
+** trampoline
+*****************************************************************/
+void trampoline::run( coro::coroutine_handle<> h ) {
+  // This can be called from a parser that is itself running in
+  // the trampoline (a builtin running its parsers in place), and
+  // the links below this one belong to whoever is running that.
+  detail::transfer_link* const base = top_;
+  next_                             = h;
+  while( true ) {
+    while( next_ ) {
+      coro::coroutine_handle<> const cur = next_;
+      next_                              = nullptr;
+      cur.resume();
+    }
+    // Nothing more to run: either h is done or the parser that
+    // was started through the link on top has failed.
+    if( top_ == base ) break;
+    detail::transfer_link& link = *top_;
+    top_                        = link.up;
+    leave();
+    next_ = link.child_failed( link );
+  }
+}
+
+/****************************************************************
+** Scopes
+*****************************************************************/
+trampoline* current_trampoline() noexcept {
+  return g_current_trampoline;
+}
+
+trampoline_scope::trampoline_scope( trampoline& t ) noexcept
+  : prev_( g_current_trampoline ) {
+  g_current_trampoline = &t;
+}
+
+trampoline_scope::~trampoline_scope() noexcept {
+  g_current_trampoline = prev_;
+}
+
+} // namespace parsco